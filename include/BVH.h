@@ -0,0 +1,51 @@
+// Bounding volume hierarchy over the bounds of scene objects, used to find the objects inside a camera's frustum
+// without testing every object in the scene.
+#pragma once
+
+#include "BoundingBox.h"
+#include "Frustum.h"
+#include "SceneObject.h"
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+// Nodes are stored depth first in a flat array: the left child of an interior node directly follows it,
+// so only the index of the right child is kept. Every node covers a contiguous range of the reordered objects.
+struct BVHNode
+{
+    BoundingBox bounds;
+    uint32_t first = 0;         // First object covered by this node
+    uint32_t count = 0;         // Number of objects covered by this node
+    uint32_t rightChild = 0;    // 0 for leaves, since the root can never be a right child
+
+    bool isLeaf() const { return rightChild == 0; }
+};
+
+class BVH
+{
+public:
+    // Builds the hierarchy with the surface area heuristic
+    void build(const std::vector<std::shared_ptr<SceneObject>>& objects);
+
+    // Updates the bounds of one object that moved, and of every node above it. The tree itself is kept,
+    // so its quality slowly degrades if objects move far; call build() again to restore it.
+    void refit(const SceneObject& sceneObj);
+
+    // Appends every object whose bounds are at least partly inside the frustum
+    void cull(const Frustum& frustum, std::vector<std::shared_ptr<SceneObject>>& visible) const;
+
+private:
+    uint32_t buildNode(uint32_t first, uint32_t count, uint32_t parent);
+
+    void refitNode(uint32_t node);
+
+    std::vector<BVHNode> _nodes;
+    std::vector<uint32_t> _parents;
+
+    // Objects in the order the leaves reference them, and their cached bounds
+    std::vector<std::shared_ptr<SceneObject>> _objects;
+    std::vector<BoundingBox> _objectBounds;
+    std::vector<uint32_t> _leafOf;
+
+    std::unordered_map<const SceneObject*, uint32_t> _slots;
+};
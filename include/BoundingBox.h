@@ -0,0 +1,43 @@
+// Axis aligned bounding box in world space.
+#pragma once
+
+#include "geometry.h"
+#include <algorithm>
+#include <limits>
+
+struct BoundingBox
+{
+    // An empty box, which any point extends
+    BoundingBox() : 
+        min{std::numeric_limits<float>::max()}, max{-std::numeric_limits<float>::max()} {}
+    BoundingBox(Vec3f min, Vec3f max) : min{min}, max{max} {}
+
+    void extend(const Vec3f& p)
+    {
+        min.x = std::min(min.x, p.x); max.x = std::max(max.x, p.x);
+        min.y = std::min(min.y, p.y); max.y = std::max(max.y, p.y);
+        min.z = std::min(min.z, p.z); max.z = std::max(max.z, p.z);
+    }
+
+    void extend(const BoundingBox& box)
+    {
+        min.x = std::min(min.x, box.min.x); max.x = std::max(max.x, box.max.x);
+        min.y = std::min(min.y, box.min.y); max.y = std::max(max.y, box.max.y);
+        min.z = std::min(min.z, box.min.z); max.z = std::max(max.z, box.max.z);
+    }
+
+    bool empty() const { return min.x > max.x; }
+
+    Vec3f centre() const { return (min + max) * 0.5f; }
+
+    // Used as the probability of a ray/frustum hitting the box by the surface area heuristic
+    float surfaceArea() const
+    {
+        if (empty()) return 0;
+        Vec3f d = max - min;
+        return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    Vec3f min;
+    Vec3f max;
+};
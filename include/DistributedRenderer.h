@@ -0,0 +1,25 @@
+// Sort-last rendering across worker processes. Each worker loads and renders only its share of the scene's objects, so
+// no process ever holds the whole scene, and the workers then composite their images by depth.
+#pragma once
+
+#include "Camera.h"
+#include "Lighting.h"
+#include "Renderer.h"
+#include "SceneLoader.h"
+#include <vector>
+
+class DistributedRenderer
+{
+public:
+    DistributedRenderer(unsigned workers);
+
+    // Forks the workers and splits the jobs between them in order. Each worker renders its objects with a copy of the
+    // renderer's pipeline state, and the composited image ends up in the renderer's buffers.
+    // Compositing by depth only gives the same image as drawing everything together when the depth test and writes are
+    // on, blending is off and there are no shadows (objects would cast them onto other workers' objects). Otherwise
+    // the jobs are all loaded and rendered in this process. Returns false if a worker failed.
+    bool render(const Camera& camera, const Lighting& lighting, const std::vector<SceneLoader::Job>& jobs, Renderer& renderer);
+
+private:
+    unsigned _workers;
+};
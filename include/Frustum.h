@@ -0,0 +1,29 @@
+// The volume of world space that a camera can see, bounded by six planes.
+#pragma once
+
+#include "Camera.h"
+#include "BoundingBox.h"
+
+// Points p with normal.dotProduct(p) + d >= 0 are on the inside of the plane
+struct Plane
+{
+    Vec3f normal;
+    float d = 0;
+
+    float distance(const Vec3f& p) const { return normal.dotProduct(p) + d; }
+};
+
+struct Frustum
+{
+    enum Containment { OUTSIDE, INTERSECTS, INSIDE };
+
+    Frustum(const Camera& camera);
+
+    Containment classify(const BoundingBox& box) const;
+
+    // False only if the sphere is entirely outside one of the planes
+    bool intersects(const Vec3f& centre, float radius) const;
+
+    // Left, right, bottom, top, near, far
+    Plane planes[6];
+};
@@ -0,0 +1,78 @@
+// Lambert diffuse and Blinn-Phong specular lighting from directional and point lights.
+#pragma once
+
+#include "geometry.h"
+#include "Vertex.h"
+#include "ShadowMap.h"
+#include <vector>
+
+struct Light
+{
+    enum Type { DIRECTIONAL, POINT };
+
+    Type type = DIRECTIONAL;
+    Vec3f direction = Vec3f(0, 0, -1);      // Which way a directional light shines
+    Vec3f position;                         // Where a point light is. Point lights do not fall off with distance.
+    Vec3f colour = Vec3f(1);                // Intensity of each channel, 1 being full
+
+    bool operator==(const Light& other) const;
+};
+
+// Components of a set of vertices, each in its own array so the lighting loops run over contiguous floats
+struct VertexArrays
+{
+    void resize(size_t size);
+    size_t size() const;
+
+    std::vector<float> x, y, z;
+    std::vector<float> nx, ny, nz;
+    std::vector<float> r, g, b;
+};
+
+struct Lighting
+{
+    // Colour of a point of the surface with normal n, as seen from eye. Surfaces are lit on the side facing the eye,
+    // whichever way the normal points.
+    Colour shade(const Vec3f& p, const Vec3f& n, const Vec3f& eye, const Vec3f& albedo) const;
+
+    // Lights every vertex at once (Gouraud shading), one light at a time over the whole arrays
+    void lightVertices(const VertexArrays& vertices, const Vec3f& eye, std::vector<Colour>& colours) const;
+
+    bool operator==(const Lighting& other) const;
+
+    // No lights leaves the scene unlit, drawn in its vertex colours
+    std::vector<Light> lights;
+
+    float ambient = 0.2f;       // Fraction of the colour kept where no light reaches
+    float specular = 0.3f;      // Strength of the highlights
+    float shininess = 32;       // Blinn-Phong exponent, larger for smaller highlights
+};
+
+// Lights every pixel from the interpolated position and normal (Phong shading). Slower than lighting the vertices, but
+// highlights and light falling across large triangles come out right. Darkened in shadow when given a shadow map.
+struct PerPixelLightingShader
+{
+    static constexpr int ATTRIBUTES = 9;    // r, g, b, world x, y, z, normal x, y, z
+    static constexpr bool WRITES_COLOUR = true;
+
+    void vertex(const Vertex& pWorld, std::array<float, ATTRIBUTES>& attributes) const
+    {
+        attributes = {(float)pWorld.colour.x, (float)pWorld.colour.y, (float)pWorld.colour.z, pWorld.x, pWorld.y, pWorld.z,
+                      pWorld.normal.x, pWorld.normal.y, pWorld.normal.z};
+    }
+
+    Colour shade(const std::array<float, ATTRIBUTES>& attributes) const
+    {
+        Vec3f p(attributes[3], attributes[4], attributes[5]);
+        Vec3f n(attributes[6], attributes[7], attributes[8]);
+        Colour colour = lighting->shade(p, n.normalize(), eye, Vec3f(attributes[0], attributes[1], attributes[2]));
+        if (!shadowMap || !shadowMap->inShadow(p)) return colour;
+
+        const float factor = ShadowedColourShader::SHADOW_FACTOR;
+        return Colour((unsigned char)(colour.x * factor + 0.5f), (unsigned char)(colour.y * factor + 0.5f), (unsigned char)(colour.z * factor + 0.5f));
+    }
+
+    const Lighting* lighting;
+    Vec3f eye;
+    const ShadowMap* shadowMap = nullptr;
+};
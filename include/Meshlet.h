@@ -0,0 +1,38 @@
+// Small clusters of a mesh's triangles, each with bounds tight enough to cull it on its own before any of its
+// vertices are transformed.
+#pragma once
+
+#include "geometry.h"
+#include <vector>
+#include <cstdint>
+
+const size_t MESHLET_MAX_VERTICES = 64;
+const size_t MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet
+{
+    // True if the rasterizer would reject every triangle as facing away when seen from eye
+    bool facesAway(const Vec3f& eye) const;
+
+    std::vector<uint32_t> vertices;     // Vertices of the mesh the meshlet uses
+    std::vector<uint32_t> indices;      // Triangle list into vertices above
+
+    // Sphere around every vertex
+    Vec3f centre;
+    float radius = 0;
+
+    // Every triangle's front facing normal lies within coneCutoff of coneAxis, where coneCutoff is the sine of the
+    // cone's half angle. The rasterizer draws triangles whose (v2 - v0) x (v1 - v0) points towards the eye.
+    // A cutoff of 1 or more means the normals are too spread out for the cone to cull anything.
+    Vec3f coneAxis;
+    float coneCutoff = 1;
+};
+
+// Splits a triangle list into meshlets of at most maxVertices vertices and maxTriangles triangles. Each meshlet is grown
+// from a seed triangle through the triangles sharing its vertices, so that it stays compact and its bounds stay small.
+std::vector<Meshlet> buildMeshlets(
+    const std::vector<Vec3f>& positions,
+    const std::vector<uint32_t>& indices,
+    size_t maxVertices = MESHLET_MAX_VERTICES,
+    size_t maxTriangles = MESHLET_MAX_TRIANGLES
+);
@@ -0,0 +1,90 @@
+// Random access to the objects of a large OBJ file. An index of where every "o" record is in the file is kept next to
+// it, so an object can be read and parsed on its own, and parsed objects are cached under a memory budget. Only the
+// objects asked for are ever in memory: scene objects copy what they need out of the parsed data, and the cache only
+// saves parsing an object again when it is loaded twice.
+#pragma once
+
+#include "ObjLoader.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Where an "o" record is in the file, up to the next one, and how many of each element came before it
+struct ObjIndexEntry
+{
+    std::string name;
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    ObjCounts before;
+};
+
+struct ObjIndex
+{
+    // Scans the records of a file, without parsing any numbers. Triangles before the first "o" record make an
+    // object named "default", as they do for parseObj().
+    static ObjIndex build(const char* begin, const char* end);
+
+    // Reads or writes the index file. Reading fails if the index was built for a different version of the OBJ file, going
+    // by its size and modification time, or if any of its entries reaches past the end of the file.
+    bool read(const std::string& path, uint64_t fileSize, int64_t fileModified);
+    bool write(const std::string& path) const;
+
+    // Returns nullptr if there is no object with that name
+    const ObjIndexEntry* find(const std::string& name) const;
+
+    std::vector<ObjIndexEntry> entries;
+    uint64_t fileSize = 0;
+    int64_t fileModified = 0;       // In nanoseconds
+
+private:
+    void buildLookup();
+
+    std::unordered_map<std::string, size_t> _byName;
+};
+
+// Default for ObjLibrary::setMemoryBudget()
+const size_t OBJ_LIBRARY_MEMORY_BUDGET = 256 << 20;
+
+class ObjLibrary
+{
+public:
+    // Reads the index from path + ".index", or builds it and writes it there if it is missing or out of date
+    explicit ObjLibrary(const std::string& path);
+
+    // One library per file, shared by everyone loading from it
+    static std::shared_ptr<ObjLibrary> open(const std::string& path);
+
+    // Reads and parses only the object's record, which is then cached. The data holds that one object, with
+    // indices into its own arrays. Without an object of that name, the data has no objects.
+    std::shared_ptr<const ObjData> load(const std::string& name);
+
+    // Cached objects are dropped, least recently loaded first, while they take more than the budget. This bounds the
+    // parse cache only, the geometry of the scene objects built from it is theirs and not counted. Dropping an object
+    // only drops the cache's reference, anyone still holding the data keeps it until they are done.
+    void setMemoryBudget(size_t bytes);
+
+private:
+    struct CachedObject
+    {
+        std::shared_ptr<const ObjData> data;
+        size_t bytes;
+        std::list<std::string>::iterator recent;
+    };
+
+    // Parses one entry's bytes of the file
+    ObjData parse(const ObjIndexEntry& entry) const;
+
+    void evict();
+
+    std::string _path;
+    ObjIndex _index;
+
+    size_t _budget = OBJ_LIBRARY_MEMORY_BUDGET;
+    size_t _used = 0;
+    std::unordered_map<std::string, CachedObject> _cache;
+    std::list<std::string> _recent;         // Names of the cached objects, most recently loaded first
+    std::mutex _mutex;
+};
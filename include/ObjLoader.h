@@ -0,0 +1,57 @@
+// Parser for Wavefront OBJ text. The records are split into newline aligned chunks that are parsed in parallel, then
+// merged. The result is the same as parsing them from start to end on one thread.
+#pragma once
+
+#include "geometry.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Indices of one corner of a face into the file's global arrays, starting at 0. -1 when the corner has none.
+struct ObjCorner
+{
+    int32_t v = -1;
+    int32_t vt = -1;
+    int32_t vn = -1;
+};
+
+// An "o" record and the triangles that follow it, up to the next object
+struct ObjObject
+{
+    std::string name;
+    uint32_t firstTriangle = 0;
+    uint32_t triangleCount = 0;
+};
+
+struct ObjData
+{
+    std::vector<Vec3f> positions;
+    std::vector<Vec2f> texcoords;
+    std::vector<Vec3f> normals;
+
+    // Three corners per triangle. Faces with more corners are split into a fan of triangles.
+    std::vector<ObjCorner> corners;
+
+    std::vector<ObjObject> objects;
+
+    // Returns nullptr if there is no object with that name
+    const ObjObject* findObject(const std::string& name) const;
+};
+
+// Number of each element, such as how many a file has before some point
+struct ObjCounts
+{
+    uint32_t positions = 0;
+    uint32_t texcoords = 0;
+    uint32_t normals = 0;
+};
+
+// Index of a corner referring to an element before the parsed records, when parsing part of a file
+const int32_t OBJ_INDEX_BEFORE = -2;
+
+// Parses OBJ records in memory. When they are part of a larger file, before holds how many elements came first: face
+// indices are made relative to the parsed part, and the ones referring back past its start become OBJ_INDEX_BEFORE.
+ObjData parseObj(const char* begin, const char* end, unsigned threads = 0, ObjCounts before = {});
+
+// The newline ending the line p is on, or end if it is the last line
+const char* findLineEnd(const char* p, const char* end);
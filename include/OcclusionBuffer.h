@@ -0,0 +1,51 @@
+// Coarse depth buffer that a few large occluders are drawn into, so that objects hidden behind them can be found and
+// skipped before they are transformed or rasterized.
+#pragma once
+
+#include "Rasterizer.h"
+#include <vector>
+#include <cstdint>
+
+struct OcclusionStats
+{
+    uint32_t occluders = 0;     // Objects drawn into the occlusion buffer
+    uint32_t tested = 0;        // Other visible objects tested against it
+    uint32_t hidden = 0;        // Tested objects found hidden, which were not drawn
+};
+
+// Each cell stands for CELL_SIZE x CELL_SIZE pixels. A cell only gets a depth once occluders cover the centre of every
+// pixel in it, and it keeps the depth least likely to pass the depth test of those occluders, so whatever loses against
+// a cell would lose against every pixel it covers at full resolution too. Cells keep a mask of the pixel centres covered
+// so far, so that the triangles sharing an edge across a cell fill it together.
+class OcclusionBuffer
+{
+public:
+    static constexpr int32_t CELL_SIZE = 4;
+
+    OcclusionBuffer(uint32_t width, uint32_t height);
+
+    // Every cell starts with the given depth, which nothing loses against
+    void clear(float depth);
+
+    // Draws a triangle list in raster space. Like the rasterizer, triangles facing away are skipped, and so are triangles
+    // with a vertex outside [-far, -near], which would project wrongly or not be drawn at all.
+    void drawTriangles(const std::vector<RasterVertex<0>>& vertices, const std::vector<uint32_t>& indices, float near, float far);
+
+    // True if the depth test fails for depth `nearest` at every pixel of the rectangle
+    bool isHidden(const Rect& rect, float nearest) const;
+
+private:
+    struct Cell
+    {
+        float depth;            // Depth behind which everything in the cell is hidden
+        uint16_t mask;          // Pixel centres covered by the occluders drawn since depth last changed
+        float maskDepth;        // Depth behind which everything under the mask is hidden
+    };
+
+    // Bits of the pixels of a cell outside of the image, which count as covered
+    uint16_t outsideMask(int32_t cx, int32_t cy) const;
+
+    std::vector<Cell> _cells;
+    int32_t _cellsX, _cellsY;
+    uint32_t _width, _height;
+};
@@ -0,0 +1,514 @@
+// Triangle setup and pixel loops of the rasterizer. Everything that is constant over a triangle is turned into plane equations
+// over raster space once, so walking the pixels only takes additions and a single reciprocal per pixel.
+//
+// Triangles are walked in one of three ways depending on their size: tiny triangles test their few pixels before paying for
+// attribute setup, large triangles are walked in 8x8 blocks that are accepted or rejected whole where possible, and the
+// rest are walked row by row over their bounding box.
+//
+// The pixel loop is a template over a PipelineState, so every combination of depth test, depth write, blending and shader
+// compiles to its own loop without per pixel branches on the state. selectPipeline() picks one once per draw.
+#pragma once
+
+#include "Vertex.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Pixels from (x0, y0) to (x1, y1), inclusive
+struct Rect
+{
+    int32_t x0, y0, x1, y1;
+
+    bool empty() const { return x0 > x1 || y0 > y1; }
+    bool overlaps(const Rect& other) const { return x0 <= other.x1 && other.x0 <= x1 && y0 <= other.y1 && other.y0 <= y1; }
+
+    // Smallest rectangle containing both
+    Rect merged(const Rect& other) const
+    {
+        return {std::min(x0, other.x0), std::min(y0, other.y0), std::max(x1, other.x1), std::max(y1, other.y1)};
+    }
+
+    bool operator==(const Rect& other) const = default;
+};
+
+// f(x, y) = a*x + b*y + c
+struct PlaneEquation
+{
+    float a = 0, b = 0, c = 0;
+
+    float at(float x, float y) const { return a*x + b*y + c; }
+};
+
+// A vertex in raster space. z is the depth used by the depth test, attributes are anything interpolated across the triangle.
+template<int ATTRIBUTES>
+struct RasterVertex
+{
+    float x, y, z;
+    std::array<float, ATTRIBUTES> attributes;
+};
+
+template<int ATTRIBUTES>
+struct TriangleSetup
+{
+    // Computes the bounding box and edge functions. Returns false if the triangle covers no pixels: it is outside the scissor
+    // rectangle, degenerate or facing away (negative area).
+    bool setupEdges(const RasterVertex<ATTRIBUTES>& v0, const RasterVertex<ATTRIBUTES>& v1, const RasterVertex<ATTRIBUTES>& v2,
+                    const Rect& scissor)
+    {
+        // Find bounding box, which spans from (xmin, ymix) to (xmax, ymax)
+        float xmin = std::min(std::min(v0.x, v1.x), v2.x);
+        float ymin = std::min(std::min(v0.y, v1.y), v2.y);
+        float xmax = std::max(std::max(v0.x, v1.x), v2.x);
+        float ymax = std::max(std::max(v0.y, v1.y), v2.y);
+
+        // Checks if the triangle is out of bounds
+        if (!(xmax >= scissor.x0 && xmin < scissor.x1 + 1 && ymax >= scissor.y0 && ymin < scissor.y1 + 1)) return false;
+
+        // Clipped before the casts, which would overflow for vertices close to the camera plane
+        x0 = (int32_t)std::floor(std::max(xmin, (float)scissor.x0));
+        x1 = (int32_t)std::floor(std::min(xmax, (float)scissor.x1));
+        y0 = (int32_t)std::floor(std::max(ymin, (float)scissor.y0));
+        y1 = (int32_t)std::floor(std::min(ymax, (float)scissor.y1));
+
+        // Same edge functions as edgeFunction(), written as planes: w0 is opposite v0, and so on.
+        edges[0] = edgePlane(v1, v2);
+        edges[1] = edgePlane(v2, v0);
+        edges[2] = edgePlane(v0, v1);
+
+        area = edges[2].at(v2.x, v2.y);
+        return area > 0;
+    }
+
+    // Computes the depth and attribute planes. Only valid after setupEdges() succeeded.
+    void setupInterpolation(const RasterVertex<ATTRIBUTES>& v0, const RasterVertex<ATTRIBUTES>& v1, const RasterVertex<ATTRIBUTES>& v2)
+    {
+        // Every attribute plane is a blend of the barycentric planes w_i / area, weighted by the value at each vertex.
+        // Dividing by z first makes the result linear in screen space, so it can be interpolated with planes.
+        float oneOverZ[3] = {1 / v0.z, 1 / v1.z, 1 / v2.z};
+        depth = blend(area, oneOverZ[0], oneOverZ[1], oneOverZ[2]);
+
+        for (int i{0}; i < ATTRIBUTES; ++i)
+        {
+            attributes[i] = blend(area, v0.attributes[i] * oneOverZ[0], v1.attributes[i] * oneOverZ[1], v2.attributes[i] * oneOverZ[2]);
+        }
+    }
+
+    PlaneEquation edges[3];
+    PlaneEquation depth;                                // 1/z
+    std::array<PlaneEquation, ATTRIBUTES> attributes;   // attribute/z
+    float area;                                         // Twice the triangle's area, as edgeFunction() halves it
+
+    // Bounding box of the triangle, clipped to the scissor rectangle
+    int32_t x0, x1, y0, y1;
+
+private:
+    static PlaneEquation edgePlane(const RasterVertex<ATTRIBUTES>& v1, const RasterVertex<ATTRIBUTES>& v2)
+    {
+        // Expanded form of ((x - v1.x) * (v2.y - v1.y) - (y - v1.y) * (v2.x - v1.x)) / 2
+        PlaneEquation plane;
+        plane.a = (v2.y - v1.y) / 2;
+        plane.b = -(v2.x - v1.x) / 2;
+        plane.c = (v1.y * (v2.x - v1.x) - v1.x * (v2.y - v1.y)) / 2;
+        return plane;
+    }
+
+    PlaneEquation blend(float area, float f0, float f1, float f2) const
+    {
+        PlaneEquation plane;
+        plane.a = (edges[0].a * f0 + edges[1].a * f1 + edges[2].a * f2) / area;
+        plane.b = (edges[0].b * f0 + edges[1].b * f1 + edges[2].b * f2) / area;
+        plane.c = (edges[0].c * f0 + edges[1].c * f1 + edges[2].c * f2) / area;
+        return plane;
+    }
+};
+
+struct TileClear;
+
+// Buffers a draw writes into, both width * height in size. Only pixels inside the scissor rectangle are drawn.
+struct RenderTarget
+{
+    RenderTarget(Colour* colour, float* depth, uint32_t width, uint32_t height) : 
+        colour{colour}, depth{depth}, width{width}, height{height}, scissor{0, 0, int32_t(width) - 1, int32_t(height) - 1} {}
+
+    Colour* colour;
+    float* depth;
+    uint32_t width;
+    uint32_t height;
+    Rect scissor;
+
+    // When set, the buffers may still hold the last frame in tiles this tracks as cleared, which draws clear before use
+    TileClear* tiles = nullptr;
+};
+
+// Clears the buffers of a render target lazily, a tile at a time. Clearing only flags every tile; a tile is written with
+// the clear values the first time a triangle's bounding box reaches it, so the memory is touched once while drawing it
+// anyway. Tiles no triangle reached get their colour filled in by resolve(), and their depth is only written when asked for.
+struct TileClear
+{
+    static constexpr int32_t TILE_SIZE = 32;
+
+    enum State : uint8_t
+    {
+        CLEAR_PENDING,      // Neither buffer has been cleared
+        DEPTH_PENDING,      // Resolved: the colour has been cleared but nothing was drawn, so the depth is stale
+        CLEARED
+    };
+
+    TileClear(uint32_t width, uint32_t height) :
+        tilesX{(width + TILE_SIZE - 1) / TILE_SIZE}, tilesY{(height + TILE_SIZE - 1) / TILE_SIZE}, states(tilesX * tilesY, CLEARED) {}
+
+    void clear(Colour colour, float depth)
+    {
+        clearColour = colour;
+        clearDepth = depth;
+        std::fill(states.begin(), states.end(), CLEAR_PENDING);
+        pending = true;
+    }
+
+    // Clears the tiles overlapping the rectangle that have not been yet
+    void touch(const RenderTarget& target, const Rect& rect)
+    {
+        if (!pending) return;
+
+        for (int32_t ty{rect.y0 / TILE_SIZE}; ty <= rect.y1 / TILE_SIZE; ++ty)
+        {
+            for (int32_t tx{rect.x0 / TILE_SIZE}; tx <= rect.x1 / TILE_SIZE; ++tx)
+            {
+                State& state = states[ty * tilesX + tx];
+                if (state == CLEARED) continue;
+
+                fillTile(target, tx, ty, state == CLEAR_PENDING, true);
+                state = CLEARED;
+            }
+        }
+    }
+
+    // Clears the colour of every tile nothing was drawn in, so the colour buffer holds the whole frame. With depth set,
+    // clears their depth as well, for when the depth buffer is read too.
+    void resolve(const RenderTarget& target, bool depth = false)
+    {
+        if (!pending) return;
+
+        for (uint32_t ty{0}; ty < tilesY; ++ty)
+        {
+            for (uint32_t tx{0}; tx < tilesX; ++tx)
+            {
+                State& state = states[ty * tilesX + tx];
+                if (state == CLEARED || (state == DEPTH_PENDING && !depth)) continue;
+
+                fillTile(target, tx, ty, state == CLEAR_PENDING, depth);
+                state = depth ? CLEARED : DEPTH_PENDING;
+            }
+        }
+    }
+
+    uint32_t tilesX, tilesY;
+    std::vector<State> states;
+    Colour clearColour;
+    float clearDepth = 0;
+    bool pending = false;       // Whether any tile might not be CLEARED, to skip the search when none are
+
+private:
+    void fillTile(const RenderTarget& target, int32_t tx, int32_t ty, bool colour, bool depth)
+    {
+        int32_t x0 = tx * TILE_SIZE;
+        int32_t count = std::min(TILE_SIZE, int32_t(target.width) - x0);
+        int32_t y1 = std::min((ty + 1) * TILE_SIZE, int32_t(target.height));
+        for (int32_t y{ty * TILE_SIZE}; y < y1; ++y)
+        {
+            if (colour && target.colour) std::fill_n(target.colour + y * target.width + x0, count, clearColour);
+            if (depth && target.depth) std::fill_n(target.depth + y * target.width + x0, count, clearDepth);
+        }
+    }
+};
+
+enum class BlendMode
+{
+    REPLACE,    // Overwrite the pixel
+    ADD,        // Add to the pixel, saturating at 255
+    AVERAGE     // Half of the new colour and half of the old one
+};
+
+// Shaders fill in the attributes of every vertex, and turn the interpolated attributes into a pixel's colour.
+// They declare how many attributes they need and whether they write colour at all.
+struct VertexColourShader
+{
+    static constexpr int ATTRIBUTES = 3;    // r, g, b
+    static constexpr bool WRITES_COLOUR = true;
+
+    // Remember, xyz is being used as rgb.
+    void vertex(const Vertex& pWorld, std::array<float, ATTRIBUTES>& attributes) const
+    {
+        attributes = {(float)pWorld.colour.x, (float)pWorld.colour.y, (float)pWorld.colour.z};
+    }
+
+    Colour shade(const std::array<float, ATTRIBUTES>& attributes) const
+    {
+        // Rounded and bound between 0 and 255
+        return Colour((unsigned char)std::clamp(attributes[0] + 0.5f, 0.0f, 255.0f),
+                      (unsigned char)std::clamp(attributes[1] + 0.5f, 0.0f, 255.0f),
+                      (unsigned char)std::clamp(attributes[2] + 0.5f, 0.0f, 255.0f));
+    }
+};
+
+// Only fills the depth buffer. Nothing is interpolated but depth and no colour is written.
+struct DepthOnlyShader
+{
+    static constexpr int ATTRIBUTES = 0;
+    static constexpr bool WRITES_COLOUR = false;
+
+    void vertex(const Vertex&, std::array<float, ATTRIBUTES>&) const {}
+    Colour shade(const std::array<float, ATTRIBUTES>&) const { return Colour(); }
+};
+
+enum class DepthTest
+{
+    OFF,
+    LESS,           // Keep the pixel if it is closer than what is in the depth buffer
+    LESS_EQUAL      // Also keep it at equal depth, for drawing over a depth prepass of the same geometry
+};
+
+template<typename SHADER, DepthTest DEPTH_TEST = DepthTest::LESS, bool DEPTH_WRITE = true, BlendMode BLEND = BlendMode::REPLACE>
+struct PipelineState
+{
+    using Shader = SHADER;
+    static constexpr int ATTRIBUTES = SHADER::ATTRIBUTES;
+    static constexpr DepthTest depthTest = DEPTH_TEST;
+    static constexpr bool depthWrite = DEPTH_WRITE;
+    static constexpr BlendMode blend = BLEND;
+};
+
+template<BlendMode BLEND>
+inline void blendPixel(Colour& dst, const Colour& src)
+{
+    if constexpr (BLEND == BlendMode::REPLACE)
+    {
+        dst = src;
+    } else if constexpr (BLEND == BlendMode::ADD)
+    {
+        dst.x = (unsigned char)std::min(dst.x + src.x, 255);
+        dst.y = (unsigned char)std::min(dst.y + src.y, 255);
+        dst.z = (unsigned char)std::min(dst.z + src.z, 255);
+    } else
+    {
+        dst.x = (unsigned char)((dst.x + src.x) / 2);
+        dst.y = (unsigned char)((dst.y + src.y) / 2);
+        dst.z = (unsigned char)((dst.z + src.z) / 2);
+    }
+}
+
+// Triangles whose bounding box is at most this many pixels on each side take the small triangle path
+const int32_t SMALL_TRIANGLE_SIZE = 4;
+
+// Side of the blocks large triangles are walked in, in pixels. Triangles at least this big on both sides are walked in blocks.
+const int32_t BLOCK_SIZE = 8;
+
+// Depth test, shading and blending of one covered pixel. oneOverZ and attributes are the interpolated 1/z and attribute/z.
+template<typename PIPELINE>
+inline void shadePixel(const RenderTarget& target, const typename PIPELINE::Shader& shader,
+                       int32_t x, int32_t y, float oneOverZ, const std::array<float, PIPELINE::ATTRIBUTES>& attributes)
+{
+    float z = 1/oneOverZ;
+    float& depth = target.depth[y * target.width + x];
+
+    // Check if z is closer than what is stored in z buffer
+    if constexpr (PIPELINE::depthTest == DepthTest::LESS) { if (!(z < depth)) return; }
+    if constexpr (PIPELINE::depthTest == DepthTest::LESS_EQUAL) { if (!(z <= depth)) return; }
+    if constexpr (PIPELINE::depthWrite) depth = z;
+    if constexpr (!PIPELINE::Shader::WRITES_COLOUR) return;
+
+    // Perspective correct attributes
+    std::array<float, PIPELINE::ATTRIBUTES> values;
+    for (int i{0}; i < PIPELINE::ATTRIBUTES; ++i) { values[i] = attributes[i] * z; }
+
+    blendPixel<PIPELINE::blend>(target.colour[y * target.width + x], shader.shade(values));
+}
+
+// Walks the pixels [xStart, xEnd] of row y. Evaluates every plane at the middle of the first pixel, then steps one pixel at a time.
+// TEST_EDGES is false for spans known to be entirely inside the triangle.
+template<typename PIPELINE, bool TEST_EDGES>
+inline void rasterizeSpan(const TriangleSetup<PIPELINE::ATTRIBUTES>& triangle, const RenderTarget& target, const typename PIPELINE::Shader& shader,
+                          int32_t y, int32_t xStart, int32_t xEnd)
+{
+    constexpr int ATTRIBUTES = PIPELINE::ATTRIBUTES;
+
+    float px = xStart + 0.5f, py = y + 0.5f;
+    float w0 = triangle.edges[0].at(px, py);
+    float w1 = triangle.edges[1].at(px, py);
+    float w2 = triangle.edges[2].at(px, py);
+    float oneOverZ = triangle.depth.at(px, py);
+    std::array<float, ATTRIBUTES> attributes;
+    for (int i{0}; i < ATTRIBUTES; ++i) { attributes[i] = triangle.attributes[i].at(px, py); }
+
+    for (int32_t x{xStart}; x <= xEnd; x++)
+    {
+        // Pixel sample lies within the triangle
+        if (!TEST_EDGES || (w0 >= 0 && w1 >= 0 && w2 >= 0)) shadePixel<PIPELINE>(target, shader, x, y, oneOverZ, attributes);
+
+        if constexpr (TEST_EDGES)
+        {
+            w0 += triangle.edges[0].a;
+            w1 += triangle.edges[1].a;
+            w2 += triangle.edges[2].a;
+        }
+        oneOverZ += triangle.depth.a;
+        for (int i{0}; i < ATTRIBUTES; ++i) { attributes[i] += triangle.attributes[i].a; }
+    }
+}
+
+enum class BlockCoverage { OUTSIDE, PARTIAL, INSIDE };
+
+// Edge functions are linear, so if the samples at the four corners of a block are inside an edge, every sample in the block is,
+// and if they are all outside one edge, none are.
+template<int ATTRIBUTES>
+inline BlockCoverage classifyBlock(const TriangleSetup<ATTRIBUTES>& triangle, int32_t bx, int32_t by, int32_t size)
+{
+    float left = bx + 0.5f, right = bx + size - 0.5f;
+    float top = by + 0.5f, bottom = by + size - 0.5f;
+
+    bool inside = true;
+    for (const PlaneEquation& edge : triangle.edges)
+    {
+        float c0 = edge.at(left, top), c1 = edge.at(right, top);
+        float c2 = edge.at(left, bottom), c3 = edge.at(right, bottom);
+
+        if (c0 < 0 && c1 < 0 && c2 < 0 && c3 < 0) return BlockCoverage::OUTSIDE;
+        if (c0 < 0 || c1 < 0 || c2 < 0 || c3 < 0) inside = false;
+    }
+    return inside ? BlockCoverage::INSIDE : BlockCoverage::PARTIAL;
+}
+
+// Fills a block that is entirely inside the triangle, or tests the pixels of one that is partly inside after splitting it into
+// quarters that may themselves be accepted or rejected whole.
+template<typename PIPELINE>
+void rasterizeBlock(const TriangleSetup<PIPELINE::ATTRIBUTES>& triangle, const RenderTarget& target, const typename PIPELINE::Shader& shader,
+                    int32_t bx, int32_t by, int32_t size)
+{
+    BlockCoverage coverage = classifyBlock(triangle, bx, by, size);
+    if (coverage == BlockCoverage::OUTSIDE) return;
+
+    if (coverage == BlockCoverage::PARTIAL && size > BLOCK_SIZE / 2)
+    {
+        int32_t half = size / 2;
+        rasterizeBlock<PIPELINE>(triangle, target, shader, bx, by, half);
+        rasterizeBlock<PIPELINE>(triangle, target, shader, bx + half, by, half);
+        rasterizeBlock<PIPELINE>(triangle, target, shader, bx, by + half, half);
+        rasterizeBlock<PIPELINE>(triangle, target, shader, bx + half, by + half, half);
+        return;
+    }
+
+    // Blocks are aligned to the block grid, so they can hang over the bounding box (which is clipped to the scissor rectangle)
+    int32_t xStart = std::max(bx, triangle.x0), xEnd = std::min(bx + size - 1, triangle.x1);
+    int32_t yStart = std::max(by, triangle.y0), yEnd = std::min(by + size - 1, triangle.y1);
+
+    for (int32_t y{yStart}; y <= yEnd; y++)
+    {
+        if (coverage == BlockCoverage::INSIDE) rasterizeSpan<PIPELINE, false>(triangle, target, shader, y, xStart, xEnd);
+        else rasterizeSpan<PIPELINE, true>(triangle, target, shader, y, xStart, xEnd);
+    }
+}
+
+// Sets up and rasterizes one triangle, picking the traversal that suits its size
+template<typename PIPELINE>
+void rasterize(const RasterVertex<PIPELINE::ATTRIBUTES>& v0, const RasterVertex<PIPELINE::ATTRIBUTES>& v1, const RasterVertex<PIPELINE::ATTRIBUTES>& v2,
+               const RenderTarget& target, const typename PIPELINE::Shader& shader)
+{
+    TriangleSetup<PIPELINE::ATTRIBUTES> triangle;
+    if (!triangle.setupEdges(v0, v1, v2, target.scissor)) return;
+    if (target.tiles) target.tiles->touch(target, {triangle.x0, triangle.y0, triangle.x1, triangle.y1});
+
+    int32_t width = triangle.x1 - triangle.x0 + 1;
+    int32_t height = triangle.y1 - triangle.y0 + 1;
+
+    if (width <= SMALL_TRIANGLE_SIZE && height <= SMALL_TRIANGLE_SIZE)
+    {
+        // Find the covered pixels first. Most tiny triangles cover one or two pixel centres, or none at all,
+        // in which case the interpolation setup is skipped entirely.
+        int32_t covered[SMALL_TRIANGLE_SIZE * SMALL_TRIANGLE_SIZE][2];
+        int32_t count = 0;
+        for (int32_t y{triangle.y0}; y <= triangle.y1; y++)
+        {
+            for (int32_t x{triangle.x0}; x <= triangle.x1; x++)
+            {
+                float px = x + 0.5f, py = y + 0.5f;
+                if (triangle.edges[0].at(px, py) >= 0 && triangle.edges[1].at(px, py) >= 0 && triangle.edges[2].at(px, py) >= 0)
+                {
+                    covered[count][0] = x;
+                    covered[count][1] = y;
+                    count++;
+                }
+            }
+        }
+        if (count == 0) return;
+
+        triangle.setupInterpolation(v0, v1, v2);
+        for (int32_t i{0}; i < count; ++i)
+        {
+            float px = covered[i][0] + 0.5f, py = covered[i][1] + 0.5f;
+            std::array<float, PIPELINE::ATTRIBUTES> attributes;
+            for (int k{0}; k < PIPELINE::ATTRIBUTES; ++k) { attributes[k] = triangle.attributes[k].at(px, py); }
+            shadePixel<PIPELINE>(target, shader, covered[i][0], covered[i][1], triangle.depth.at(px, py), attributes);
+        }
+        return;
+    }
+
+    triangle.setupInterpolation(v0, v1, v2);
+
+    if (width >= BLOCK_SIZE && height >= BLOCK_SIZE)
+    {
+        // Walk the blocks of the grid that overlap the bounding box
+        for (int32_t by = triangle.y0 & ~(BLOCK_SIZE - 1); by <= triangle.y1; by += BLOCK_SIZE)
+        {
+            for (int32_t bx = triangle.x0 & ~(BLOCK_SIZE - 1); bx <= triangle.x1; bx += BLOCK_SIZE)
+            {
+                rasterizeBlock<PIPELINE>(triangle, target, shader, bx, by, BLOCK_SIZE);
+            }
+        }
+        return;
+    }
+
+    // Iterate through the bounding box in the image buffer
+    for (int32_t y{triangle.y0}; y <= triangle.y1; y++) { rasterizeSpan<PIPELINE, true>(triangle, target, shader, y, triangle.x0, triangle.x1); }
+}
+
+// Rasterizes every triangle of an indexed triangle list
+template<typename PIPELINE>
+void drawTriangles(const std::vector<RasterVertex<PIPELINE::ATTRIBUTES>>& vertices, const std::vector<uint32_t>& indices,
+                   const RenderTarget& target, const typename PIPELINE::Shader& shader)
+{
+    for (size_t i{0}; i + 2 < indices.size(); i += 3)
+    {
+        rasterize<PIPELINE>(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]], target, shader);
+    }
+}
+
+template<typename SHADER>
+using DrawFunction = void (*)(const std::vector<RasterVertex<SHADER::ATTRIBUTES>>&, const std::vector<uint32_t>&, const RenderTarget&, const SHADER&);
+
+// Instantiates drawTriangles() for every combination of the runtime state, and returns the one matching it
+template<typename SHADER>
+DrawFunction<SHADER> selectPipeline(DepthTest depthTest, bool depthWrite, BlendMode blend)
+{
+    auto byBlend = [&]<DepthTest DEPTH_TEST, bool DEPTH_WRITE>() -> DrawFunction<SHADER>
+    {
+        switch (blend)
+        {
+            case BlendMode::ADD:     return drawTriangles<PipelineState<SHADER, DEPTH_TEST, DEPTH_WRITE, BlendMode::ADD>>;
+            case BlendMode::AVERAGE: return drawTriangles<PipelineState<SHADER, DEPTH_TEST, DEPTH_WRITE, BlendMode::AVERAGE>>;
+            default:                 return drawTriangles<PipelineState<SHADER, DEPTH_TEST, DEPTH_WRITE, BlendMode::REPLACE>>;
+        }
+    };
+    auto byDepthWrite = [&]<DepthTest DEPTH_TEST>() -> DrawFunction<SHADER>
+    {
+        return depthWrite ? byBlend.template operator()<DEPTH_TEST, true>() : byBlend.template operator()<DEPTH_TEST, false>();
+    };
+
+    switch (depthTest)
+    {
+        case DepthTest::OFF:        return byDepthWrite.template operator()<DepthTest::OFF>();
+        case DepthTest::LESS_EQUAL: return byDepthWrite.template operator()<DepthTest::LESS_EQUAL>();
+        default:                    return byDepthWrite.template operator()<DepthTest::LESS>();
+    }
+}
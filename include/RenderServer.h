@@ -0,0 +1,64 @@
+// Long running render process. The scene, camera and buffers are loaded once and kept resident while
+// commands are read line by line from a stream (stdin when launched with --server).
+//
+// Commands:
+//  load <name> [r g b]             Loads a Cube from the obj file and adds it to the scene
+//  budget <megabytes>              Sets how much memory objects parsed from the obj file may keep cached
+//  camera <x> <y> <z> <rx> <ry> <rz>   Sets the camera position and rotation (degrees)
+//  colour <name> <r> <g> <b>       Sets every vertex of the object to a colour
+//  move <name> <dx> <dy> <dz>      Translates the object in world space
+//  depth <on|off> <on|off>        Turns the depth test and depth writes on or off
+//  blend <replace|add|average>     Sets how new pixels are combined with the frame buffer
+//  prepass <on|off>                Renders depth before shading, so hidden surfaces are never shaded
+//  incremental <on|off>            Only redraws what changed since the last render
+//  occlusion <on|off>              Skips objects hidden behind the largest ones on screen
+//  light directional <dx> <dy> <dz> [r g b]   Adds a light shining along a direction
+//  light point <x> <y> <z> [r g b]             Adds a light at a position. Without lights the scene is unlit.
+//  light clear                     Removes every light
+//  lighting <vertex|pixel>         Lights the vertices and interpolates (default), or lights every pixel
+//  shadow <x> <y> <z> <rx> <ry> <rz>   Casts shadows from a light placed like a camera
+//  shadow off                      Stops casting shadows
+//  frametime <milliseconds>        Renders at a lower resolution whenever needed to keep to that raster time, and
+//                                  scales the frames up to the full resolution
+//  frametime off                   Always renders at the full resolution
+//  frametime                       Answers "ok <width> <height> <milliseconds>": the resolution of the next render and
+//                                  the raster time of the last one
+//  render <path>                   Renders the scene to a PPM file
+//  render -                        Renders the scene and streams the PPM back, after an "ok <bytes>" line
+//  stats                           Answers "ok <occluders> <tested> <hidden>" for the occlusion culling of the last render
+//  quit                            Stops the server
+//
+// Every command is answered with a single "ok" or "error <reason>" line.
+#pragma once
+
+#include "Camera.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "ShadowMap.h"
+#include "ResolutionScaler.h"
+#include <iostream>
+#include <string>
+#include <memory>
+
+class RenderServer
+{
+public:
+    RenderServer(uint32_t width, uint32_t height);
+
+    // Reads and executes commands until quit or the end of the input stream
+    void run(std::istream& in, std::ostream& out);
+
+    // Executes a single command line. Returns false once the server should stop.
+    bool execute(const std::string& line, std::ostream& out);
+
+    Camera camera;
+    Scene scene;
+    Renderer renderer;
+
+private:
+    // Re-rendered before every frame, since objects may have moved
+    std::unique_ptr<ShadowMap> _shadowMap;
+
+    // Picks the resolution of every render once given a frame time
+    ResolutionScaler _scaler;
+};
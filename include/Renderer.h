@@ -0,0 +1,181 @@
+// Rasterizes a Scene as seen from a Camera into a colour and depth buffer that persist between frames.
+#pragma once
+
+#include "Camera.h"
+#include "Scene.h"
+#include "Frustum.h"
+#include "Vertex.h"
+#include "View.h"
+#include "Rasterizer.h"
+#include "ShadowMap.h"
+#include "OcclusionBuffer.h"
+#include "Lighting.h"
+#include "SceneLoader.h"
+#include <vector>
+#include <tuple>
+#include <unordered_map>
+#include <iostream>
+
+class Renderer
+{
+public:
+    Renderer(uint32_t width, uint32_t height);
+
+    // Clears the buffers then draws every object of the scene inside the camera's frustum.
+    // With incremental set, only redraws the parts of the last frame that changed.
+    void render(const Camera& camera, Scene& scene);
+
+    // Draws the objects of the scene, then the loader's objects in the order of their jobs, each as soon as it is loaded,
+    // adding them to the scene. Where surfaces meet at equal depth, the one drawn first is kept, so the image is the same
+    // however fast the objects load. Always a full redraw. Without depth test and writes, or when blending, waits for all
+    // of the objects and renders as above instead.
+    void render(const Camera& camera, Scene& scene, SceneLoader& loader);
+
+    // Rectangles the last render redrew, the whole image unless it was incremental
+    const std::vector<Rect>& getDirtyRects() const;
+
+    // What occlusion culling did in the last render, all zero if it did not run
+    const OcclusionStats& getOcclusionStats() const;
+
+    // Renders nothing but depth, into a buffer of width * height that is cleared first
+    void renderDepth(const Camera& camera, Scene& scene, float* depth, uint32_t width, uint32_t height);
+
+    // Renders the scene's depth from the shadow map's light
+    void renderShadowMap(Scene& scene, ShadowMap& shadowMap);
+
+    // Only flags the buffers as cleared, they are written as the next frame is drawn (see TileClear)
+    void clear(Colour colour, float depth);
+
+    // Writes the clear depth into the parts of the depth buffer the last frame drew nothing in, which it otherwise leaves
+    // holding older frames. Only needed to read zBuffer after a render.
+    void resolveDepth();
+
+    // Reallocates the buffers for another resolution. The next render is a full redraw.
+    void resize(uint32_t width, uint32_t height);
+
+    // Writes the frame buffer as a binary PPM image
+    void writePPM(std::ostream& os) const;
+
+    uint32_t getWidth() const;
+    uint32_t getHeight() const;
+
+    Colour background = Colour(50);
+
+    // Pipeline state, applied to every draw
+    bool depthTest = true;
+    bool depthWrite = true;
+    BlendMode blendMode = BlendMode::REPLACE;
+
+    // Fills the depth buffer before shading, so pixels are only shaded by the surface that ends up in front, apart from
+    // pixels on edges between triangles (see drawVisible())
+    bool depthPrepass = false;
+
+    // Redraw only the screen rectangles of objects that moved, changed, appeared or disappeared since the last frame.
+    // Falls back to a full redraw whenever the camera or the pipeline state changes, or shadows are on (a moving object
+    // can shadow anything).
+    bool incremental = false;
+
+    // Cull the meshlets of every object separately, rather than drawing whole objects
+    bool clusterCulling = true;
+
+    // Draw the objects largest on screen into a coarse depth buffer first, and skip the objects it shows are hidden behind
+    // them. Only runs with depth test and writes on and REPLACE blending, where hidden objects cannot change the image.
+    bool occlusionCulling = false;
+
+    // Light every pixel from its interpolated normal, rather than lighting the vertices and interpolating their colours
+    bool perPixelLighting = false;
+
+    // When set, shading darkens the points this shadow map's light cannot see. It has to be rendered separately.
+    const ShadowMap* shadowMap = nullptr;
+
+    // Both buffers are allocated once and reused by every frame
+    std::vector<Colour> frameBuffer;
+    std::vector<float> zBuffer;
+
+private:
+    // What an object looked like on screen when last drawn
+    struct DrawnObject
+    {
+        Rect bounds;
+        uint64_t version;
+    };
+
+    // Everything other than the objects that decides what the last frame looks like
+    struct FrameState
+    {
+        Camera camera;
+        Colour background;
+        bool depthTest, depthWrite, depthPrepass;
+        BlendMode blendMode;
+        bool shadows;
+        Lighting lighting;
+        bool perPixelLighting;
+
+        bool operator==(const FrameState& other) const;
+    };
+
+    // Draws the objects overlapping the target's scissor rectangle, with the depth prepass if enabled
+    void drawVisible(const View& view, const Frustum& frustum, const RenderTarget& target, const Lighting& lighting);
+
+    // Draws one object with the shader the pipeline state and lighting call for
+    void drawShaded(const SceneObject& sceneObj, const View& view, const Frustum& frustum, const RenderTarget& target, 
+                    const Lighting& lighting, DepthTest test);
+
+    // Keeps what the frame drew, for the next incremental one to compare with
+    void rememberFrame(const FrameState& frame);
+
+    // Draws the occluders into _occlusion and removes the objects found hidden from _visible
+    void cullOccluded(const View& view);
+
+    // Finds what changed since the last frame into _dirtyRects, merging the ones that overlap
+    void findDirtyRects();
+
+    // Objects found by the last cull, kept to reuse the allocation
+    std::vector<std::shared_ptr<SceneObject>> _visible;
+
+    // Screen rectangles of _visible, in the same order
+    std::vector<Rect> _visibleBounds;
+
+    // Objects drawn by the last frame and the state it was drawn with
+    std::unordered_map<const SceneObject*, DrawnObject> _drawn;
+    FrameState _lastFrame;
+    bool _hasLastFrame = false;
+
+    std::vector<Rect> _dirtyRects;
+
+    TileClear _tiles;
+
+    OcclusionBuffer _occlusion;
+    OcclusionStats _occlusionStats;
+    std::vector<RasterVertex<0>> _occluderVertices;
+
+    // Raster space vertices of the object being drawn, one buffer for each number of attributes a shader can have
+    std::tuple<
+        std::vector<RasterVertex<DepthOnlyShader::ATTRIBUTES>>,
+        std::vector<RasterVertex<VertexColourShader::ATTRIBUTES>>,
+        std::vector<RasterVertex<ShadowedColourShader::ATTRIBUTES>>,
+        std::vector<RasterVertex<PerPixelLightingShader::ATTRIBUTES>>
+    > _rasterVertices;
+
+    // Meshlets of the object being drawn that were not culled
+    std::vector<const Meshlet*> _drawnMeshlets;
+
+    // The object's vertices that are drawn, and their colours once lit
+    VertexArrays _vertexArrays;
+    std::vector<Colour> _litColours;
+
+    // Indices of those vertices in the object, and for every vertex of the object, its index in _litColours
+    std::vector<uint32_t> _litVertices;
+    std::vector<uint32_t> _litSlots;
+
+    // Transforms the object's vertices, runs the shader's vertex stage on them and draws its triangles. When drawing the
+    // full mesh, meshlets outside the frustum or facing away are skipped, and so are the ones hidden behind what the depth
+    // buffer holds if occlusionTest is set, which is only right when the depth test is on. With vertexLighting, the shader
+    // gets the vertices in their lit colours, and only the vertices of the meshlets not skipped are lit.
+    template<typename SHADER>
+    void drawObject(const SceneObject& sceneObj, const View& view, const Frustum& frustum, const SHADER& shader, 
+                    const RenderTarget& target, DrawFunction<SHADER> draw, bool occlusionTest, const Lighting* vertexLighting = nullptr);
+
+    uint32_t _width;
+    uint32_t _height;
+};
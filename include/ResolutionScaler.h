@@ -0,0 +1,61 @@
+// Renders at whatever resolution keeps frames close to a target time, and scales the frames up to the output
+// resolution, so that interactive previews keep a steady latency as the scene gets heavier.
+#pragma once
+
+#include "Camera.h"
+#include "Scene.h"
+#include "Renderer.h"
+#include <vector>
+#include <iostream>
+
+class ResolutionScaler
+{
+public:
+    ResolutionScaler(uint32_t width, uint32_t height);
+
+    // Renders the scene at the current resolution and scales the frame up into output. Then picks the resolution of
+    // the next frame from how long the renderer took, leaving the shadow map and the upscale out of it.
+    void render(Renderer& renderer, const Camera& camera, Scene& scene);
+
+    // Writes the upscaled frame as a binary PPM image
+    void writePPM(std::ostream& os) const;
+
+    // Raster time to aim for in milliseconds. 0 always renders at the output resolution.
+    float targetMilliseconds = 0;
+
+    // How long the renderer took for the last frame
+    float getLastMilliseconds() const;
+
+    // Resolution the next frame renders at
+    uint32_t getRenderWidth() const;
+    uint32_t getRenderHeight() const;
+
+    uint32_t getWidth() const;
+    uint32_t getHeight() const;
+
+    // The last frame at the output resolution
+    std::vector<Colour> output;
+
+private:
+    // Bilinear filter from the renderer's frame buffer to output
+    void upscale(const Renderer& renderer);
+
+    // Where an output column or row samples the smaller image: between pixel 0 and 1, weight / 256 of the way to 1
+    struct Sample
+    {
+        uint32_t p0, p1;
+        uint32_t weight;
+    };
+    static void computeSamples(uint32_t from, uint32_t to, std::vector<Sample>& samples);
+
+    // Both sides are scaled by steps / SCALE_STEPS, which keeps the aspect ratio and the number of resolutions small
+    uint32_t _steps;
+
+    float _lastMilliseconds = 0;
+
+    std::vector<Sample> _columns, _rows;
+    uint32_t _sampledWidth = 0, _sampledHeight = 0;
+
+    uint32_t _width;
+    uint32_t _height;
+};
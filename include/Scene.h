@@ -0,0 +1,36 @@
+// A collection of scene objects that stays loaded for as long as the Scene lives.
+#pragma once
+
+#include "SceneObject.h"
+#include "BVH.h"
+#include "Frustum.h"
+#include "Lighting.h"
+#include <vector>
+#include <memory>
+#include <string>
+
+class Scene
+{
+public:
+    void add(std::shared_ptr<SceneObject> sceneObj);
+
+    // Returns nullptr if there is no object with that name
+    std::shared_ptr<SceneObject> find(const std::string& name) const;
+
+    const std::vector<std::shared_ptr<SceneObject>>& getObjects() const;
+
+    // Must be called after an object of the scene moves, so the BVH stays correct
+    void refit(const SceneObject& sceneObj);
+
+    // Collects the objects that are at least partly inside the frustum. The BVH is rebuilt first if objects were added.
+    void cull(const Frustum& frustum, std::vector<std::shared_ptr<SceneObject>>& visible);
+
+    // Lights shining on every object
+    Lighting lighting;
+
+private:
+    std::vector<std::shared_ptr<SceneObject>> _objects;
+
+    BVH _bvh;
+    bool _bvhOutdated = false;
+};
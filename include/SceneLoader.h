@@ -0,0 +1,54 @@
+// Builds scene objects on loader threads and hands them over in order as soon as they are ready, so that rendering can
+// start on the first objects while the rest are still being parsed.
+#pragma once
+
+#include "SceneObject.h"
+#include "Scene.h"
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class SceneLoader
+{
+public:
+    // Builds one object, e.g. [] { return std::make_shared<Cube>("Block_1"); }
+    using Job = std::function<std::shared_ptr<SceneObject>()>;
+
+    // Starts running the jobs on that many threads, or one per hardware thread if 0
+    SceneLoader(std::vector<Job> jobs, unsigned threads = 0);
+
+    // Waits for the jobs still running
+    ~SceneLoader();
+
+    SceneLoader(const SceneLoader&) = delete;
+    SceneLoader& operator=(const SceneLoader&) = delete;
+
+    // Blocks until the next object is loaded and returns it. Objects are handed over in the order of their jobs, so
+    // that drawing them as they come gives the same image every time, even where surfaces meet at equal depth. As the
+    // threads also start the jobs in order, an object is only held back by an earlier one that is slower to load.
+    // Returns nullptr once every object has been handed over.
+    std::shared_ptr<SceneObject> next();
+
+    // Waits for the objects not handed over yet and adds them to the scene, in the order of their jobs
+    void finish(Scene& scene);
+
+private:
+    void work();
+
+    std::vector<Job> _jobs;
+    std::vector<std::shared_ptr<SceneObject>> _loaded;
+
+    // Which jobs have finished
+    std::vector<bool> _finished;
+
+    size_t _started = 0;
+    size_t _handedOver = 0;
+
+    std::mutex _mutex;
+    std::condition_variable _done;
+
+    std::vector<std::thread> _threads;
+};
@@ -1,17 +1,26 @@
 #pragma once 
 
-#include <fstream>
 #include "geometry.h"
 #include "Vertex.h"
+#include "ObjLoader.h"
+#include "BoundingBox.h"
+#include "Meshlet.h"
 #include <vector>
 #include <iostream>
 #include <memory>
 
+// Obj file that objects are loaded from when no other is given
+extern const std::string OBJ_FILE;
+
 class SceneObject
 {
 public:
+    // Loads the object from the default obj file, reading only its part of the file (see ObjLibrary)
     SceneObject(std::string name);
 
+    // Loads the object from an already parsed obj file
+    SceneObject(std::string name, const ObjData& obj);
+
     SceneObject(const SceneObject& other);
 
     // Pure virtual function
@@ -19,6 +28,25 @@ public:
 
     const std::string getName() const;
 
+    // Smallest box around every vertex, in world space
+    BoundingBox getBounds() const;
+
+    // Moves every vertex by offset. A Scene holding this object has to be told with Scene::refit().
+    void translate(const Vec3f& offset);
+
+    const std::vector<std::shared_ptr<Vertex>>& getVertices() const;
+
+    // Changes every time the object moves or changes colour, so renderers can tell what to redraw
+    uint64_t getVersion() const;
+
+    // Builds simplified versions of the mesh, each with about half the triangles of the one before.
+    // Called once the mesh is loaded; stops early when the mesh cannot be simplified any further, or is already small.
+    // Simplifies the welded positions, so vertices split by normal do not tear the mesh apart.
+    void buildLODs(uint32_t maxLevels = 4);
+
+    // Picks the level of detail for an object covering about projectedSize pixels across
+    uint32_t selectLOD(float projectedSize) const;
+
     friend std::ostream& operator<<(std::ostream& os, const SceneObject& sceneObj)
     {
         sceneObj.print(os);
@@ -27,14 +55,28 @@ public:
     
     std::vector<std::vector< std::shared_ptr<Vertex> >> triangles;
 
+    // Triangle lists into the vertices for each level of detail. Level 0 is the full mesh.
+    // Every level indexes the same vertices, so colour changes and moves apply to all of them.
+    std::vector<std::vector<uint32_t>> lods;
+
+    // The full mesh (level 0) split into clusters that can be culled separately
+    std::vector<Meshlet> meshlets;
+
 protected:
+    // To be called by anything that changes the vertices
+    void markChanged();
+
     // Shared pointers so that we can change the properties of every vertex from this one dimensional vector 
     // to reflect in every triangle made from that vertex
     std::vector<std::shared_ptr<Vertex>> vertices;
 
+    // Which of the object's positions in the file each vertex was made from, counting from 0. Several vertices share
+    // a position where faces give it different normals.
+    std::vector<uint32_t> sourceVertices;
+
 private:
-    std::ifstream _inFile;
     std::string _name;
+    uint64_t _version = 0;
 };
 
 class Cube : public SceneObject
@@ -0,0 +1,48 @@
+// Depth of the scene as seen from a light, used by the shading pass to find which points the light cannot reach.
+#pragma once
+
+#include "View.h"
+#include "Rasterizer.h"
+#include <vector>
+
+struct ShadowMap
+{
+    ShadowMap(const Camera& light, uint32_t width, uint32_t height);
+
+    // True if something closer to the light covers the point. Points outside of the light's image are lit.
+    bool inShadow(const Vec3f& pWorld) const;
+
+    // Projection into the light's image, and the depth rendered into it
+    View view;
+    std::vector<float> depth;
+
+    // Keeps surfaces from shadowing themselves through depth precision errors, in world units
+    float bias = 0.15f;
+};
+
+// Vertex colour, darkened where the shadow map says the light is blocked. The world position is interpolated
+// (perspective correct) so every pixel can be looked up in the shadow map.
+struct ShadowedColourShader
+{
+    static constexpr int ATTRIBUTES = 6;    // r, g, b, world x, y, z
+    static constexpr bool WRITES_COLOUR = true;
+
+    // Fraction of the colour kept in shadow
+    static constexpr float SHADOW_FACTOR = 0.4f;
+
+    void vertex(const Vertex& pWorld, std::array<float, ATTRIBUTES>& attributes) const
+    {
+        attributes = {(float)pWorld.colour.x, (float)pWorld.colour.y, (float)pWorld.colour.z, pWorld.x, pWorld.y, pWorld.z};
+    }
+
+    Colour shade(const std::array<float, ATTRIBUTES>& attributes) const
+    {
+        float light = shadowMap->inShadow(Vec3f(attributes[3], attributes[4], attributes[5])) ? SHADOW_FACTOR : 1;
+
+        return Colour((unsigned char)std::clamp(attributes[0] * light + 0.5f, 0.0f, 255.0f),
+                      (unsigned char)std::clamp(attributes[1] * light + 0.5f, 0.0f, 255.0f),
+                      (unsigned char)std::clamp(attributes[2] * light + 0.5f, 0.0f, 255.0f));
+    }
+
+    const ShadowMap* shadowMap;
+};
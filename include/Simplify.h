@@ -0,0 +1,15 @@
+// Mesh simplification by quadric error edge collapse (Garland & Heckbert).
+#pragma once
+
+#include "geometry.h"
+#include <vector>
+#include <cstdint>
+
+// Collapses edges of the triangle list, cheapest quadric error first, until at most targetTriangles remain or
+// no edge can be collapsed without flipping a triangle. Edges are collapsed onto one of their endpoints, so the
+// returned triangle list still indexes the original positions and no new vertices are made.
+std::vector<uint32_t> simplifyMesh(
+    const std::vector<Vec3f>& positions,
+    const std::vector<uint32_t>& indices,
+    size_t targetTriangles
+);
@@ -30,4 +30,5 @@ public:
     Vertex(Vec3f point, Colour colour);
     
     Colour colour;
+    Vec3f normal;       // Unit length, pointing out of the surface
 };
\ No newline at end of file
@@ -0,0 +1,47 @@
+// Projection of world space points into the raster space of a camera's image.
+#pragma once
+
+#include "Camera.h"
+#include "Vertex.h"
+#include "BoundingBox.h"
+#include "Rasterizer.h"
+
+// Boundaries of the image plane (canvas) for the given camera settings
+void computeScreenCoordinates(
+    const Camera& camera,
+    float &top, float &bottom, float &left, float &right
+);
+
+// Projects a point in world space to raster space. z holds the distance of the point from the camera.
+void convertToRaster(
+    const Vertex& pWorld,
+    const Camera& camera,
+    const Matrix44f& worldToCamera,
+    const float& t,
+    const float& b,
+    const float& l,
+    const float& r,
+    const uint32_t& imageWidth,
+    const uint32_t& imageHeight,
+    Vertex &pRaster
+);
+
+// Signed area of the parallelogram made by the edge v1v2 and the pixel
+float edgeFunction(const Vec3f& v1, const Vec3f& v2, const Vec3f& pixel);
+
+// Everything needed to project points into the image of a camera, computed once per frame
+struct View
+{
+    View(const Camera& camera, uint32_t width, uint32_t height);
+
+    void toRaster(const Vertex& pWorld, Vertex& pRaster) const;
+
+    // Pixels the box can cover, clipped to the image. The whole image when the box reaches behind the near clipping plane,
+    // where projecting its corners says nothing about what is inside.
+    Rect screenBounds(const BoundingBox& box) const;
+
+    Camera camera;
+    Matrix44f worldToCamera;
+    float top, bottom, left, right;     // Boundaries of the image plane
+    uint32_t width, height;             // Dimensions of the image
+};
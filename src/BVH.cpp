@@ -0,0 +1,197 @@
+#include "BVH.h"
+#include <algorithm>
+
+// Leaves hold at most this many objects
+const uint32_t MAX_LEAF_SIZE = 4;
+
+// Number of buckets the centroids are binned into when evaluating split candidates
+const uint32_t SAH_BINS = 12;
+
+void BVH::build(const std::vector<std::shared_ptr<SceneObject>>& objects)
+{
+    _objects = objects;
+    _objectBounds.resize(_objects.size());
+    for (size_t i{0}; i < _objects.size(); ++i) { _objectBounds[i] = _objects[i]->getBounds(); }
+
+    _nodes.clear();
+    _parents.clear();
+    _leafOf.assign(_objects.size(), 0);
+    _slots.clear();
+
+    if (_objects.empty()) return;
+
+    // A binary tree with at least one object per leaf has fewer than 2n nodes
+    _nodes.reserve(2 * _objects.size());
+    _parents.reserve(2 * _objects.size());
+    buildNode(0, _objects.size(), 0);
+
+    for (uint32_t i{0}; i < _objects.size(); ++i) { _slots[_objects[i].get()] = i; }
+}
+
+uint32_t BVH::buildNode(uint32_t first, uint32_t count, uint32_t parent)
+{
+    uint32_t index = _nodes.size();
+    _nodes.emplace_back();
+    _parents.push_back(parent);
+
+    BoundingBox bounds, centroidBounds;
+    for (uint32_t i{first}; i < first + count; ++i)
+    {
+        bounds.extend(_objectBounds[i]);
+        centroidBounds.extend(_objectBounds[i].centre());
+    }
+    _nodes[index].bounds = bounds;
+    _nodes[index].first = first;
+    _nodes[index].count = count;
+
+    auto makeLeaf = [&]()
+    {
+        for (uint32_t i{first}; i < first + count; ++i) { _leafOf[i] = index; }
+        return index;
+    };
+
+    if (count <= MAX_LEAF_SIZE) return makeLeaf();
+
+    // Split along the axis with the largest spread of centroids
+    Vec3f extent = centroidBounds.max - centroidBounds.min;
+    uint8_t axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+
+    // Every centroid is in the same place, so no split can separate them
+    if (extent[axis] <= 0) return makeLeaf();
+
+    // Bin centroids along the axis
+    struct Bin { BoundingBox bounds; uint32_t count = 0; };
+    Bin bins[SAH_BINS];
+    const float scale = SAH_BINS / extent[axis];
+    auto binOf = [&](uint32_t i)
+    {
+        uint32_t b = (uint32_t)((_objectBounds[i].centre()[axis] - centroidBounds.min[axis]) * scale);
+        return std::min(b, SAH_BINS - 1);
+    };
+    for (uint32_t i{first}; i < first + count; ++i)
+    {
+        Bin& bin = bins[binOf(i)];
+        bin.bounds.extend(_objectBounds[i]);
+        bin.count++;
+    }
+
+    // Sweep from the right to get the cost of everything past each split plane, then from the left to find the cheapest split
+    float rightArea[SAH_BINS];
+    uint32_t rightCount[SAH_BINS];
+    BoundingBox accumulated;
+    uint32_t accumulatedCount = 0;
+    for (int b = SAH_BINS - 1; b > 0; --b)
+    {
+        accumulated.extend(bins[b].bounds);
+        accumulatedCount += bins[b].count;
+        rightArea[b] = accumulated.surfaceArea();
+        rightCount[b] = accumulatedCount;
+    }
+
+    float bestCost = std::numeric_limits<float>::max();
+    uint32_t bestSplit = 0;
+    accumulated = BoundingBox();
+    accumulatedCount = 0;
+    for (uint32_t b{1}; b < SAH_BINS; ++b)
+    {
+        accumulated.extend(bins[b - 1].bounds);
+        accumulatedCount += bins[b - 1].count;
+        float cost = accumulated.surfaceArea() * accumulatedCount + rightArea[b] * rightCount[b];
+        if (accumulatedCount > 0 && rightCount[b] > 0 && cost < bestCost)
+        {
+            bestCost = cost;
+            bestSplit = b;
+        }
+    }
+
+    // Only happens when every centroid lands in one bin
+    if (bestSplit == 0) return makeLeaf();
+
+    // Partition the objects (and their bounds) around the split plane
+    uint32_t mid = first;
+    for (uint32_t i{first}; i < first + count; ++i)
+    {
+        if (binOf(i) < bestSplit)
+        {
+            std::swap(_objects[i], _objects[mid]);
+            std::swap(_objectBounds[i], _objectBounds[mid]);
+            mid++;
+        }
+    }
+
+    buildNode(first, mid - first, index);
+    _nodes[index].rightChild = buildNode(mid, first + count - mid, index);
+    return index;
+}
+
+void BVH::refitNode(uint32_t node)
+{
+    BVHNode& n = _nodes[node];
+    n.bounds = BoundingBox();
+    if (n.isLeaf())
+    {
+        for (uint32_t i{n.first}; i < n.first + n.count; ++i) { n.bounds.extend(_objectBounds[i]); }
+    } else
+    {
+        n.bounds.extend(_nodes[node + 1].bounds);
+        n.bounds.extend(_nodes[n.rightChild].bounds);
+    }
+}
+
+void BVH::refit(const SceneObject& sceneObj)
+{
+    auto slot = _slots.find(&sceneObj);
+    if (slot == _slots.end()) return;
+
+    _objectBounds[slot->second] = sceneObj.getBounds();
+
+    // Walk up to the root, stopping early once a node's bounds no longer change
+    uint32_t node = _leafOf[slot->second];
+    while (true)
+    {
+        BoundingBox before = _nodes[node].bounds;
+        refitNode(node);
+
+        const BoundingBox& after = _nodes[node].bounds;
+        bool unchanged = before.min.x == after.min.x && before.min.y == after.min.y && before.min.z == after.min.z &&
+                         before.max.x == after.max.x && before.max.y == after.max.y && before.max.z == after.max.z;
+        if (node == 0 || unchanged) break;
+        node = _parents[node];
+    }
+}
+
+void BVH::cull(const Frustum& frustum, std::vector<std::shared_ptr<SceneObject>>& visible) const
+{
+    if (_nodes.empty()) return;
+
+    std::vector<uint32_t> stack{0};
+    stack.reserve(64);
+
+    while (!stack.empty())
+    {
+        uint32_t index = stack.back();
+        stack.pop_back();
+        const BVHNode& node = _nodes[index];
+
+        Frustum::Containment containment = frustum.classify(node.bounds);
+        if (containment == Frustum::OUTSIDE) continue;
+
+        // Everything below a node that is entirely inside is visible, without testing further
+        if (containment == Frustum::INSIDE)
+        {
+            visible.insert(visible.end(), _objects.begin() + node.first, _objects.begin() + node.first + node.count);
+        } else if (node.isLeaf())
+        {
+            for (uint32_t i{node.first}; i < node.first + node.count; ++i)
+            {
+                if (frustum.classify(_objectBounds[i]) != Frustum::OUTSIDE) visible.push_back(_objects[i]);
+            }
+        } else
+        {
+            stack.push_back(node.rightChild);
+            stack.push_back(index + 1);
+        }
+    }
+}
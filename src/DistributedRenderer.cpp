@@ -0,0 +1,279 @@
+#include "DistributedRenderer.h"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+namespace
+{
+    bool writeAll(int fd, const void* data, size_t bytes)
+    {
+        const char* p = (const char*)data;
+        while (bytes > 0)
+        {
+            ssize_t written = ::write(fd, p, bytes);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return false;
+            p += written;
+            bytes -= written;
+        }
+        return true;
+    }
+
+    bool readAll(int fd, void* data, size_t bytes)
+    {
+        char* p = (char*)data;
+        while (bytes > 0)
+        {
+            ssize_t got = ::read(fd, p, bytes);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            p += got;
+            bytes -= got;
+        }
+        return true;
+    }
+
+    // Pixels [begin, end) of a colour and a depth buffer
+    bool sendPixels(int fd, const Colour* colour, const float* depth, size_t begin, size_t end)
+    {
+        return writeAll(fd, colour + begin, (end - begin) * sizeof(Colour)) && writeAll(fd, depth + begin, (end - begin) * sizeof(float));
+    }
+
+    bool receivePixels(int fd, Colour* colour, float* depth, size_t count)
+    {
+        return readAll(fd, colour, count * sizeof(Colour)) && readAll(fd, depth, count * sizeof(float));
+    }
+
+    // Keeps the pixel of whichever image passes the renderer's depth test. On equal depths the other image only wins if it
+    // holds objects from earlier in the scene, as those would have been drawn first and kept the pixel.
+    void composite(Colour* colour, float* depth, const Colour* otherColour, const float* otherDepth, size_t count, bool otherFirst)
+    {
+        for (size_t i{0}; i < count; ++i)
+        {
+            // Same rule as DepthTest::LESS on raster depth, minus the camera space z (see convertToRaster()): the smaller
+            // depth is kept, just as when one renderer draws both
+            if (otherDepth[i] < depth[i] || (otherFirst && otherDepth[i] == depth[i]))
+            {
+                colour[i] = otherColour[i];
+                depth[i] = otherDepth[i];
+            }
+        }
+    }
+
+    // The largest power of two not above n
+    unsigned swapGroup(unsigned n)
+    {
+        unsigned group = 1;
+        while (group * 2 <= n) group *= 2;
+        return group;
+    }
+
+    // The workers rank talks to: with a power of two group of workers, the partner of every binary swap round, and
+    // otherwise also the worker folded into it or the one it is folded into
+    std::vector<unsigned> peers(unsigned rank, unsigned workers)
+    {
+        const unsigned group = swapGroup(workers);
+        std::vector<unsigned> result;
+
+        if (rank >= group) return {rank - group};
+        if (rank + group < workers) result.push_back(rank + group);
+        for (unsigned bit{1}; bit < group; bit <<= 1) { result.push_back(rank ^ bit); }
+        return result;
+    }
+
+    struct Worker
+    {
+        unsigned rank;
+        unsigned workers;
+
+        // Socket to every other worker, -1 for the ones it never talks to
+        std::vector<int> links;
+
+        // Where the worker's piece of the final image goes
+        int result;
+    };
+
+    // Renders the worker's share of the jobs, then composites with the other workers by binary swap: in each round,
+    // pairs of workers split the part of the image they are responsible for in two, each sends the other the half it
+    // gives up and composites the half it keeps. After log2(workers) rounds every worker holds a different, final
+    // 1/workers of the image, which it sends to the coordinator. Without a power of two of workers, the extra ones
+    // first composite their whole image into a partner's and stop there.
+    bool runWorker(const Worker& worker, const Camera& camera, const Lighting& lighting, const std::vector<SceneLoader::Job>& jobs,
+                   Renderer& renderer)
+    {
+        const size_t first = jobs.size() * worker.rank / worker.workers;
+        const size_t last = jobs.size() * (worker.rank + 1) / worker.workers;
+
+        Scene scene;
+        scene.lighting = lighting;
+        SceneLoader loader{std::vector<SceneLoader::Job>(jobs.begin() + first, jobs.begin() + last)};
+        renderer.render(camera, scene, loader);
+
+        // Depth is composited too, and where nothing was drawn it may still hold the renderer's earlier frames
+        renderer.resolveDepth();
+
+        Colour* colour = renderer.frameBuffer.data();
+        float* depth = renderer.zBuffer.data();
+        const size_t pixels = renderer.frameBuffer.size();
+        std::vector<Colour> otherColour(pixels);
+        std::vector<float> otherDepth(pixels);
+
+        const unsigned group = swapGroup(worker.workers);
+        if (worker.rank >= group) return sendPixels(worker.links[worker.rank - group], colour, depth, 0, pixels);
+
+        // The folded in worker renders objects from later in the scene
+        if (worker.rank + group < worker.workers)
+        {
+            if (!receivePixels(worker.links[worker.rank + group], otherColour.data(), otherDepth.data(), pixels)) return false;
+            composite(colour, depth, otherColour.data(), otherDepth.data(), pixels, false);
+        }
+
+        size_t begin = 0;
+        size_t end = pixels;
+        for (unsigned bit{1}; bit < group; bit <<= 1)
+        {
+            const unsigned partner = worker.rank ^ bit;
+            const int link = worker.links[partner];
+            const bool lower = (worker.rank & bit) == 0;
+            const size_t middle = begin + (end - begin) / 2;
+
+            // The lower worker keeps the first half. It also sends first, so that two blocking writes never wait on
+            // each other.
+            const size_t keepBegin = lower ? begin : middle;
+            const size_t keepEnd = lower ? middle : end;
+            const size_t giveBegin = lower ? middle : begin;
+            const size_t giveEnd = lower ? end : middle;
+
+            if (lower)
+            {
+                if (!sendPixels(link, colour, depth, giveBegin, giveEnd)) return false;
+                if (!receivePixels(link, otherColour.data(), otherDepth.data(), keepEnd - keepBegin)) return false;
+            } else
+            {
+                if (!receivePixels(link, otherColour.data(), otherDepth.data(), keepEnd - keepBegin)) return false;
+                if (!sendPixels(link, colour, depth, giveBegin, giveEnd)) return false;
+            }
+
+            // Workers are merged in contiguous groups, so the partner's objects all come before ours or all after them.
+            // Folded in workers break that, which only matters to surfaces at exactly the same depth.
+            composite(colour + keepBegin, depth + keepBegin, otherColour.data(), otherDepth.data(), keepEnd - keepBegin, !lower);
+            begin = keepBegin;
+            end = keepEnd;
+        }
+
+        const uint64_t range[2] = {begin, end};
+        return writeAll(worker.result, range, sizeof(range)) && sendPixels(worker.result, colour, depth, begin, end);
+    }
+}
+
+DistributedRenderer::DistributedRenderer(unsigned workers) : _workers{std::max(1u, workers)} {}
+
+bool DistributedRenderer::render(const Camera& camera, const Lighting& lighting, const std::vector<SceneLoader::Job>& jobs, Renderer& renderer)
+{
+    if (!(renderer.depthTest && renderer.depthWrite && renderer.blendMode == BlendMode::REPLACE && !renderer.shadowMap))
+    {
+        Scene scene;
+        scene.lighting = lighting;
+        SceneLoader loader{jobs};
+        renderer.render(camera, scene, loader);
+        return true;
+    }
+
+    std::vector<std::vector<int>> links(_workers, std::vector<int>(_workers, -1));
+    std::vector<int> results(_workers, -1);
+    auto closeAll = [&]()
+    {
+        for (auto& row : links) { for (int& fd : row) { if (fd >= 0) ::close(fd); fd = -1; } }
+        for (int& fd : results) { if (fd >= 0) ::close(fd); fd = -1; }
+    };
+
+    bool ok = true;
+    for (unsigned rank{0}; rank < _workers && ok; ++rank)
+    {
+        for (unsigned peer : peers(rank, _workers))
+        {
+            if (peer < rank) continue;
+
+            int pair[2];
+            if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+            {
+                ok = false;
+                break;
+            }
+            links[rank][peer] = pair[0];
+            links[peer][rank] = pair[1];
+        }
+    }
+    if (!ok)
+    {
+        std::cerr << "Could not connect the render workers" << std::endl;
+        closeAll();
+        return false;
+    }
+
+    // Anything still buffered would otherwise be written again by every worker
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<pid_t> pids;
+    for (unsigned rank{0}; rank < _workers; ++rank)
+    {
+        int result[2];
+        if (::pipe(result) != 0)
+        {
+            ok = false;
+            break;
+        }
+        results[rank] = result[0];
+
+        pid_t pid = ::fork();
+        if (pid < 0)
+        {
+            ::close(result[1]);
+            ok = false;
+            break;
+        }
+
+        if (pid == 0)
+        {
+            // Only keep this worker's own ends, so a worker that dies closes every socket leading to it
+            Worker worker{rank, _workers, links[rank], result[1]};
+            for (unsigned other{0}; other < _workers; ++other)
+            {
+                if (other == rank) continue;
+                for (int fd : links[other]) { if (fd >= 0) ::close(fd); }
+            }
+            for (unsigned other{0}; other <= rank; ++other) { ::close(results[other]); }
+
+            // Leave without running the destructors of the coordinator's objects
+            _exit(runWorker(worker, camera, lighting, jobs, renderer) ? 0 : 1);
+        }
+
+        pids.push_back(pid);
+        ::close(result[1]);
+    }
+    for (auto& row : links) { for (int& fd : row) { if (fd >= 0) ::close(fd); fd = -1; } }
+
+    // Only the workers of the binary swap hold a piece of the final image
+    const size_t pixels = renderer.frameBuffer.size();
+    for (unsigned rank{0}; rank < swapGroup(_workers) && ok; ++rank)
+    {
+        uint64_t range[2];
+        ok = readAll(results[rank], range, sizeof(range)) && range[0] <= range[1] && range[1] <= pixels &&
+            receivePixels(results[rank], renderer.frameBuffer.data() + range[0], renderer.zBuffer.data() + range[0], range[1] - range[0]);
+    }
+    closeAll();
+
+    for (pid_t pid : pids)
+    {
+        int status = 0;
+        while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+    }
+
+    if (!ok) std::cerr << "A render worker failed, the image is incomplete" << std::endl;
+    return ok;
+}
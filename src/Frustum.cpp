@@ -0,0 +1,78 @@
+#include "Frustum.h"
+#include "View.h"
+
+// Plane through three points, with its normal facing towards the inside point.
+static Plane planeFromPoints(const Vec3f& a, const Vec3f& b, const Vec3f& c, const Vec3f& inside)
+{
+    Plane plane;
+    plane.normal = (b - a).crossProduct(c - a).normalize();
+    plane.d = -plane.normal.dotProduct(a);
+
+    if (plane.distance(inside) < 0)
+    {
+        plane.normal = -plane.normal;
+        plane.d = -plane.d;
+    }
+    return plane;
+}
+
+Frustum::Frustum(const Camera& camera)
+{
+    float t, b, l, r;
+    computeScreenCoordinates(camera, t, b, l, r);
+
+    const Matrix44f cameraToWorld = camera.getCameraToWorld();
+    const float n = camera.nearClippingPlane;
+    const float f = camera.farClippingPlane;
+    const float s = f / n;      // The canvas scaled out to the far plane
+
+    // Corners of the near and far planes in camera space, moved into world space.
+    // convertToRaster() projects points on either side of the camera. The scene's camera is rotated so that what it sees 
+    // lies along +z in camera space (and gets a negative raster depth), so that is the side the frustum covers.
+    // The canvas is symmetric, so the mirroring caused by dividing by -z does not change the planes.
+    Vec3f cameraCorners[8] = 
+    {
+        Vec3f(l, b, n), Vec3f(r, b, n), Vec3f(r, t, n), Vec3f(l, t, n),
+        Vec3f(l*s, b*s, f), Vec3f(r*s, b*s, f), Vec3f(r*s, t*s, f), Vec3f(l*s, t*s, f)
+    };
+    Vec3f c[8];
+    for (int i{0}; i < 8; ++i) { cameraToWorld.multVecMatrix(cameraCorners[i], c[i]); }
+
+    Vec3f inside;
+    cameraToWorld.multVecMatrix(Vec3f(0, 0, (n + f) / 2), inside);
+
+    planes[0] = planeFromPoints(c[0], c[3], c[4], inside);     // Left
+    planes[1] = planeFromPoints(c[1], c[2], c[5], inside);     // Right
+    planes[2] = planeFromPoints(c[0], c[1], c[4], inside);     // Bottom
+    planes[3] = planeFromPoints(c[3], c[2], c[7], inside);     // Top
+    planes[4] = planeFromPoints(c[0], c[1], c[2], inside);     // Near
+    planes[5] = planeFromPoints(c[4], c[5], c[6], inside);     // Far
+}
+
+Frustum::Containment Frustum::classify(const BoundingBox& box) const
+{
+    Containment result = INSIDE;
+    for (const Plane& plane : planes)
+    {
+        // The corners of the box furthest along and furthest against the plane's normal
+        Vec3f positive(plane.normal.x >= 0 ? box.max.x : box.min.x,
+                       plane.normal.y >= 0 ? box.max.y : box.min.y,
+                       plane.normal.z >= 0 ? box.max.z : box.min.z);
+        Vec3f negative(plane.normal.x >= 0 ? box.min.x : box.max.x,
+                       plane.normal.y >= 0 ? box.min.y : box.max.y,
+                       plane.normal.z >= 0 ? box.min.z : box.max.z);
+
+        if (plane.distance(positive) < 0) return OUTSIDE;
+        if (plane.distance(negative) < 0) result = INTERSECTS;
+    }
+    return result;
+}
+
+bool Frustum::intersects(const Vec3f& centre, float radius) const
+{
+    for (const Plane& plane : planes)
+    {
+        if (plane.distance(centre) < -radius) return false;
+    }
+    return true;
+}
@@ -0,0 +1,195 @@
+#include "Lighting.h"
+#include <algorithm>
+#include <cmath>
+
+bool Light::operator==(const Light& other) const
+{
+    auto same = [](const Vec3f& a, const Vec3f& b) { return a.x == b.x && a.y == b.y && a.z == b.z; };
+
+    return type == other.type && same(direction, other.direction) && same(position, other.position) && same(colour, other.colour);
+}
+
+bool Lighting::operator==(const Lighting& other) const
+{
+    return lights == other.lights && ambient == other.ambient && specular == other.specular && shininess == other.shininess;
+}
+
+void VertexArrays::resize(size_t size)
+{
+    for (std::vector<float>* component : {&x, &y, &z, &nx, &ny, &nz, &r, &g, &b}) { component->resize(size); }
+}
+
+size_t VertexArrays::size() const { return x.size(); }
+
+Colour Lighting::shade(const Vec3f& p, const Vec3f& n, const Vec3f& eye, const Vec3f& albedo) const
+{
+    Vec3f diffuse(ambient), highlight;
+    Vec3f toEye = Vec3f(eye - p).normalize();
+
+    // Lit on whichever side is seen
+    Vec3f normal = n.dotProduct(toEye) < 0 ? -n : n;
+
+    for (const Light& light : lights)
+    {
+        Vec3f toLight = light.type == Light::DIRECTIONAL ? -light.direction : light.position - p;
+        toLight.normalize();
+
+        float lambert = normal.dotProduct(toLight);
+        if (lambert <= 0) continue;
+
+        // Blinn-Phong: the highlight is brightest where the normal is halfway between the light and the eye
+        Vec3f halfway = Vec3f(toLight + toEye).normalize();
+        float phong = specular * std::pow(std::max(normal.dotProduct(halfway), 0.0f), shininess);
+
+        diffuse = diffuse + light.colour * lambert;
+        highlight = highlight + light.colour * phong;
+    }
+
+    return Colour((unsigned char)std::clamp(albedo.x * diffuse.x + 255 * highlight.x + 0.5f, 0.0f, 255.0f),
+                  (unsigned char)std::clamp(albedo.y * diffuse.y + 255 * highlight.y + 0.5f, 0.0f, 255.0f),
+                  (unsigned char)std::clamp(albedo.z * diffuse.z + 255 * highlight.z + 0.5f, 0.0f, 255.0f));
+}
+
+// Added to squared lengths, so 1 / length stays finite for the zero vector, whose components then stay 0
+const float MIN_SQUARED_LENGTH = 1e-30f;
+
+// The loops of lightVertices() that write more than one array. The compiler only trusts __restrict on parameters, and
+// without it has to test every pair of arrays for overlap, which it gives up on.
+
+// Unit vectors from every vertex to a point
+static void directionsTo(const Vec3f& point, const VertexArrays& vertices, float* __restrict lx, float* __restrict ly, float* __restrict lz)
+{
+    const size_t count = vertices.size();
+    const float* x = vertices.x.data();
+    const float* y = vertices.y.data();
+    const float* z = vertices.z.data();
+    const float px = point.x, py = point.y, pz = point.z;
+
+    for (size_t i{0}; i < count; ++i)
+    {
+        float dx = px - x[i], dy = py - y[i], dz = pz - z[i];
+        float inverse = 1 / std::sqrt(dx*dx + dy*dy + dz*dz + MIN_SQUARED_LENGTH);
+        lx[i] = dx * inverse;
+        ly[i] = dy * inverse;
+        lz[i] = dz * inverse;
+    }
+}
+
+// The diffuse and highlight cosines of a light at every vertex, lit on whichever side is seen
+static void cosines(const Vec3f& eye, const VertexArrays& vertices, const float* lx, const float* ly, const float* lz,
+                    float* __restrict lambert, float* __restrict nDotH)
+{
+    const size_t count = vertices.size();
+    const float* x = vertices.x.data();
+    const float* y = vertices.y.data();
+    const float* z = vertices.z.data();
+    const float* nx = vertices.nx.data();
+    const float* ny = vertices.ny.data();
+    const float* nz = vertices.nz.data();
+    const float eyeX = eye.x, eyeY = eye.y, eyeZ = eye.z;
+
+    for (size_t i{0}; i < count; ++i)
+    {
+        float ex = eyeX - x[i], ey = eyeY - y[i], ez = eyeZ - z[i];
+        float eInverse = 1 / std::sqrt(ex*ex + ey*ey + ez*ez + MIN_SQUARED_LENGTH);
+
+        float side = std::copysign(1.0f, nx[i]*ex + ny[i]*ey + nz[i]*ez);
+
+        float hx = lx[i] + ex * eInverse, hy = ly[i] + ey * eInverse, hz = lz[i] + ez * eInverse;
+        float hInverse = 1 / std::sqrt(hx*hx + hy*hy + hz*hz + MIN_SQUARED_LENGTH);
+
+        lambert[i] = std::max((nx[i]*lx[i] + ny[i]*ly[i] + nz[i]*lz[i]) * side, 0.0f);
+        nDotH[i] = std::max((nx[i]*hx + ny[i]*hy + nz[i]*hz) * hInverse * side, 0.0f);
+    }
+}
+
+void Lighting::lightVertices(const VertexArrays& vertices, const Vec3f& eye, std::vector<Colour>& colours) const
+{
+    const size_t count = vertices.size();
+
+    // Light gathered by each vertex, diffuse multiplies the vertex colour and highlights are added on top
+    std::vector<float> diffuse[3], highlight[3];
+    for (int c{0}; c < 3; ++c)
+    {
+        diffuse[c].assign(count, ambient);
+        highlight[c].assign(count, 0);
+    }
+
+    // Same sums as shade(), turned inside out so that every loop over the vertices is straight line code the compiler
+    // can vectorize: the type of light is picked outside of them, selects are masks and min/max, and the highlight's
+    // power gets passes of its own. Everything the loops read is copied into locals first, as stores through the float
+    // pointers could otherwise change it and it would be loaded again for every vertex.
+    std::vector<float> scratch[5];
+    for (auto& buffer : scratch) { buffer.resize(count); }
+    float* lx = scratch[0].data();
+    float* ly = scratch[1].data();
+    float* lz = scratch[2].data();
+    float* lambert = scratch[3].data();
+    float* phong = scratch[4].data();
+
+    float* d[3] = {diffuse[0].data(), diffuse[1].data(), diffuse[2].data()};
+    float* h[3] = {highlight[0].data(), highlight[1].data(), highlight[2].data()};
+
+    const float specularWeight = specular;
+
+    for (const Light& light : lights)
+    {
+        if (light.type == Light::DIRECTIONAL)
+        {
+            Vec3f direction = Vec3f(-light.direction).normalize();
+            std::fill_n(lx, count, direction.x);
+            std::fill_n(ly, count, direction.y);
+            std::fill_n(lz, count, direction.z);
+        } else
+        {
+            directionsTo(light.position, vertices, lx, ly, lz);
+        }
+
+        // Leaves nDotH in phong, which is raised to the power of shininess below
+        cosines(eye, vertices, lx, ly, lz, lambert, phong);
+
+        // By squaring when shininess is a whole number, as it usually is. Only the general case calls std::pow, which
+        // does not vectorize. The light direction is not needed anymore, so it holds the powers of nDotH.
+        if (shininess == std::floor(shininess) && shininess >= 0 && shininess <= 1024)
+        {
+            float* base = lx;
+            std::copy_n(phong, count, base);
+            std::fill_n(phong, count, 1.0f);
+            for (uint32_t exponent = shininess; exponent > 0; exponent >>= 1)
+            {
+                if (exponent & 1) { for (size_t i{0}; i < count; ++i) { phong[i] *= base[i]; } }
+                for (size_t i{0}; i < count; ++i) { base[i] *= base[i]; }
+            }
+        } else
+        {
+            const float exponent = shininess;
+            for (size_t i{0}; i < count; ++i) { phong[i] = std::pow(phong[i], exponent); }
+        }
+
+        const float r = light.colour.x, g = light.colour.y, b = light.colour.z;
+        for (size_t i{0}; i < count; ++i)
+        {
+            // No highlight on the side facing away from the light
+            float facing = lambert[i] > 0 ? 1.0f : 0.0f;
+            float highlightWeight = specularWeight * phong[i] * facing;
+
+            d[0][i] += r * lambert[i];
+            d[1][i] += g * lambert[i];
+            d[2][i] += b * lambert[i];
+            h[0][i] += r * highlightWeight;
+            h[1][i] += g * highlightWeight;
+            h[2][i] += b * highlightWeight;
+        }
+    }
+
+    // Written as bytes a channel at a time, since the Colour constructor is not inlined and the compiler does not
+    // vectorize stores interleaving three channels
+    colours.resize(count);
+    unsigned char* rgb = (unsigned char*)colours.data();
+    const float* albedo[3] = {vertices.r.data(), vertices.g.data(), vertices.b.data()};
+    for (int c{0}; c < 3; ++c)
+    {
+        const float* a = albedo[c];
+        for (size_t i{0}; i < count; ++i) { rgb[3 * i + c] = (unsigned char)(int)std::min(std::max(a[i] * d[c][i] + 255 * h[c][i] + 0.5f, 0.0f), 255.0f); }
+    }
+}
@@ -0,0 +1,114 @@
+#include "Meshlet.h"
+#include "BoundingBox.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+bool Meshlet::facesAway(const Vec3f& eye) const
+{
+    if (coneCutoff >= 1) return false;
+
+    // Every point p of the sphere has to see every normal n of the cone facing away, dot(n, p - eye) >= 0. That holds
+    // when p - eye is within 90 degrees minus the cone's half angle of the axis, for the worst p the sphere allows.
+    Vec3f toCentre = centre - eye;
+    return coneAxis.dotProduct(toCentre) >= toCentre.length() * coneCutoff + radius * (1 + coneCutoff);
+}
+
+// Fills in the bounding sphere and normal cone of a meshlet whose vertices and indices are set
+static void computeBounds(Meshlet& meshlet, const std::vector<Vec3f>& positions)
+{
+    BoundingBox box;
+    for (uint32_t v : meshlet.vertices) { box.extend(positions[v]); }
+    meshlet.centre = box.centre();
+    for (uint32_t v : meshlet.vertices) { meshlet.radius = std::max(meshlet.radius, (positions[v] - meshlet.centre).length()); }
+
+    std::vector<Vec3f> normals;
+    normals.reserve(meshlet.indices.size() / 3);
+    Vec3f sum;
+    for (size_t i{0}; i < meshlet.indices.size(); i += 3)
+    {
+        const Vec3f& p0 = positions[meshlet.vertices[meshlet.indices[i]]];
+        const Vec3f& p1 = positions[meshlet.vertices[meshlet.indices[i + 1]]];
+        const Vec3f& p2 = positions[meshlet.vertices[meshlet.indices[i + 2]]];
+
+        // Degenerate triangles are never drawn, so they do not widen the cone
+        Vec3f normal = (p2 - p0).crossProduct(p1 - p0);
+        if (normal.length() == 0) continue;
+
+        normals.push_back(normal.normalize());
+        sum = sum + normals.back();
+    }
+
+    if (normals.empty() || sum.length() == 0) return;
+
+    meshlet.coneAxis = sum.normalize();
+    float minDot = 1;
+    for (const Vec3f& normal : normals) { minDot = std::min(minDot, meshlet.coneAxis.dotProduct(normal)); }
+
+    // Normals 90 degrees or more apart can face both ways at once
+    if (minDot <= 0) return;
+    meshlet.coneCutoff = std::sqrt(1 - minDot * minDot);
+}
+
+std::vector<Meshlet> buildMeshlets(const std::vector<Vec3f>& positions, const std::vector<uint32_t>& indices, size_t maxVertices, size_t maxTriangles)
+{
+    const size_t triangleCount = indices.size() / 3;
+
+    // Triangles using each vertex, as one array with offsets
+    std::vector<uint32_t> offsets(positions.size() + 1, 0);
+    for (size_t i{0}; i < triangleCount * 3; ++i) { offsets[indices[i] + 1]++; }
+    for (size_t v{0}; v < positions.size(); ++v) { offsets[v + 1] += offsets[v]; }
+    std::vector<uint32_t> adjacency(offsets.back());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i{0}; i < triangleCount * 3; ++i) { adjacency[fill[indices[i]]++] = i / 3; }
+
+    std::vector<Meshlet> meshlets;
+    std::vector<bool> used(triangleCount, false);
+    std::vector<int32_t> local(positions.size(), -1);     // Index of each vertex within the meshlet being built
+    std::deque<uint32_t> candidates;
+    size_t seed = 0;
+
+    while (true)
+    {
+        while (seed < triangleCount && used[seed]) { seed++; }
+        if (seed == triangleCount) break;
+
+        Meshlet meshlet;
+        candidates.assign(1, seed);
+        while (!candidates.empty() && meshlet.indices.size() / 3 < maxTriangles)
+        {
+            uint32_t triangle = candidates.front();
+            candidates.pop_front();
+            if (used[triangle]) continue;
+
+            const uint32_t* corners = &indices[triangle * 3];
+            size_t newVertices = 0;
+            for (int i{0}; i < 3; ++i) { newVertices += local[corners[i]] < 0; }
+
+            // Triangles that do not fit may still be picked up by a later meshlet
+            if (meshlet.vertices.size() + newVertices > maxVertices) continue;
+
+            for (int i{0}; i < 3; ++i)
+            {
+                if (local[corners[i]] < 0)
+                {
+                    local[corners[i]] = meshlet.vertices.size();
+                    meshlet.vertices.push_back(corners[i]);
+                }
+                meshlet.indices.push_back(local[corners[i]]);
+
+                for (uint32_t j{offsets[corners[i]]}; j < offsets[corners[i] + 1]; ++j)
+                {
+                    if (!used[adjacency[j]]) candidates.push_back(adjacency[j]);
+                }
+            }
+            used[triangle] = true;
+        }
+
+        for (uint32_t v : meshlet.vertices) { local[v] = -1; }
+        computeBounds(meshlet, positions);
+        meshlets.push_back(std::move(meshlet));
+    }
+
+    return meshlets;
+}
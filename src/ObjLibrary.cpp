@@ -0,0 +1,318 @@
+#include "ObjLibrary.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// First word of an index file, followed by the format version
+const std::string INDEX_HEADER = "objindex";
+const int INDEX_VERSION = 2;
+
+namespace
+{
+    // Read only mapping of a whole file, unmapped when it goes out of scope
+    struct MappedFile
+    {
+        MappedFile(const std::string& path)
+        {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) return;
+
+            struct stat info;
+            if (fstat(fd, &info) == 0 && info.st_size > 0)
+            {
+                void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapped != MAP_FAILED)
+                {
+                    data = (const char*)mapped;
+                    size = info.st_size;
+                }
+            }
+            close(fd);
+        }
+
+        ~MappedFile()
+        {
+            if (data) munmap((void*)data, size);
+        }
+
+        const char* data = nullptr;
+        size_t size = 0;
+    };
+
+    // In nanoseconds, as whole seconds miss edits made within the same second
+    int64_t modifiedTime(const struct stat& info)
+    {
+        return int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    }
+
+    bool startsWord(const char* p, const char* end, const char* word, size_t length)
+    {
+        return (size_t)(end - p) > length && std::memcmp(p, word, length) == 0 && (p[length] == ' ' || p[length] == '\t');
+    }
+
+    // Copies one object out of parsed data, with only the elements it uses
+    ObjData extractObject(const ObjData& data, const ObjObject& object)
+    {
+        ObjData result;
+        result.objects.push_back({object.name, 0, object.triangleCount});
+
+        std::unordered_map<int32_t, int32_t> positions, texcoords, normals;
+        auto remap = [](int32_t index, std::unordered_map<int32_t, int32_t>& map, const auto& from, auto& to)
+        {
+            if (index < 0 || index >= (int32_t)from.size()) return index;
+
+            auto [it, added] = map.try_emplace(index, (int32_t)to.size());
+            if (added) to.push_back(from[index]);
+            return it->second;
+        };
+
+        const size_t first = object.firstTriangle * 3;
+        for (size_t i{first}; i < first + object.triangleCount * 3; ++i)
+        {
+            const ObjCorner& corner = data.corners[i];
+            result.corners.push_back({remap(corner.v, positions, data.positions, result.positions),
+                                      remap(corner.vt, texcoords, data.texcoords, result.texcoords),
+                                      remap(corner.vn, normals, data.normals, result.normals)});
+        }
+        return result;
+    }
+
+    // True if every corner refers to an element of the data itself
+    bool isSelfContained(const ObjData& data)
+    {
+        for (const ObjCorner& corner : data.corners)
+        {
+            if (corner.v < 0 || corner.v >= (int32_t)data.positions.size()) return false;
+            if (corner.vt < -1 || corner.vt >= (int32_t)data.texcoords.size()) return false;
+            if (corner.vn < -1 || corner.vn >= (int32_t)data.normals.size()) return false;
+        }
+        return true;
+    }
+
+    size_t memoryUsed(const ObjData& data)
+    {
+        size_t bytes = sizeof(ObjData);
+        bytes += data.positions.size() * sizeof(Vec3f) + data.texcoords.size() * sizeof(Vec2f) + data.normals.size() * sizeof(Vec3f);
+        bytes += data.corners.size() * sizeof(ObjCorner);
+        for (const ObjObject& object : data.objects) { bytes += sizeof(ObjObject) + object.name.size(); }
+        return bytes;
+    }
+}
+
+ObjIndex ObjIndex::build(const char* begin, const char* end)
+{
+    ObjIndex index;
+    ObjCounts counts;
+    bool facesBeforeObjects = false;
+
+    const char* p = begin;
+    while (p < end)
+    {
+        const char* line = p;
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+
+        if (startsWord(p, end, "v", 1)) counts.positions++;
+        else if (startsWord(p, end, "vt", 2)) counts.texcoords++;
+        else if (startsWord(p, end, "vn", 2)) counts.normals++;
+        else if (startsWord(p, end, "f", 1) && index.entries.empty()) facesBeforeObjects = true;
+        else if (startsWord(p, end, "o", 1))
+        {
+            if (!index.entries.empty()) index.entries.back().end = line - begin;
+            else if (facesBeforeObjects) index.entries.push_back({"default", 0, uint64_t(line - begin), {}});
+
+            // Same trimming as parseObj()
+            p += 1;
+            while (p < end && (*p == ' ' || *p == '\t')) p++;
+            const char* name = p;
+            const char* nameEnd = findLineEnd(p, end);
+            while (nameEnd > name && (nameEnd[-1] == '\r' || nameEnd[-1] == ' ' || nameEnd[-1] == '\t')) nameEnd--;
+
+            index.entries.push_back({std::string(name, nameEnd), uint64_t(line - begin), 0, counts});
+        }
+
+        p = findLineEnd(p, end);
+        if (p < end) p++;
+    }
+
+    if (!index.entries.empty()) index.entries.back().end = end - begin;
+    else if (facesBeforeObjects) index.entries.push_back({"default", 0, uint64_t(end - begin), {}});
+
+    index.fileSize = end - begin;
+    index.buildLookup();
+    return index;
+}
+
+bool ObjIndex::read(const std::string& path, uint64_t expectedSize, int64_t expectedModified)
+{
+    std::ifstream ifs{path};
+    std::string header;
+    int version;
+    if (!(ifs >> header >> version >> fileSize >> fileModified) || header != INDEX_HEADER || version != INDEX_VERSION) return false;
+    if (fileSize != expectedSize || fileModified != expectedModified) return false;
+
+    // One object per line, the name last as it can contain spaces
+    entries.clear();
+    std::string line;
+    std::getline(ifs, line);
+    while (std::getline(ifs, line))
+    {
+        std::istringstream iss{line};
+        ObjIndexEntry entry;
+        if (!(iss >> entry.begin >> entry.end >> entry.before.positions >> entry.before.texcoords >> entry.before.normals)) return false;
+        iss.get();
+        std::getline(iss, entry.name);
+
+        // A damaged index could point past the end of the file
+        if (entry.begin > entry.end || entry.end > fileSize) return false;
+        entries.push_back(entry);
+    }
+
+    buildLookup();
+    return true;
+}
+
+bool ObjIndex::write(const std::string& path) const
+{
+    // Written aside and renamed, so a reader never sees half an index
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream ofs{temporary};
+        ofs << INDEX_HEADER << " " << INDEX_VERSION << " " << fileSize << " " << fileModified << "\n";
+        for (const ObjIndexEntry& entry : entries)
+        {
+            ofs << entry.begin << " " << entry.end << " " << entry.before.positions << " " << entry.before.texcoords << " "
+                << entry.before.normals << " " << entry.name << "\n";
+        }
+        if (!ofs) return false;
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+const ObjIndexEntry* ObjIndex::find(const std::string& name) const
+{
+    auto it = _byName.find(name);
+    return it == _byName.end() ? nullptr : &entries[it->second];
+}
+
+void ObjIndex::buildLookup()
+{
+    // The first object of a name wins, like ObjData::findObject()
+    _byName.clear();
+    for (size_t i{0}; i < entries.size(); ++i) { _byName.try_emplace(entries[i].name, i); }
+}
+
+ObjLibrary::ObjLibrary(const std::string& path) : _path{path}
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+    {
+        std::cerr << "Could not open file " << path << std::endl;
+        return;
+    }
+
+    const std::string indexPath = path + ".index";
+    if (_index.read(indexPath, info.st_size, modifiedTime(info))) return;
+
+    MappedFile file{path};
+    if (!file.data)
+    {
+        std::cerr << "Could not map file " << path << std::endl;
+        return;
+    }
+
+    _index = ObjIndex::build(file.data, file.data + file.size);
+    _index.fileModified = modifiedTime(info);
+    if (!_index.write(indexPath)) std::cerr << "Could not write index " << indexPath << std::endl;
+}
+
+std::shared_ptr<ObjLibrary> ObjLibrary::open(const std::string& path)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<ObjLibrary>> libraries;
+
+    std::lock_guard<std::mutex> lock{mutex};
+    std::shared_ptr<ObjLibrary>& library = libraries[path];
+    if (!library) library = std::make_shared<ObjLibrary>(path);
+    return library;
+}
+
+ObjData ObjLibrary::parse(const ObjIndexEntry& entry) const
+{
+    std::vector<char> bytes(entry.end - entry.begin);
+    int fd = ::open(_path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Could not open file " << _path << std::endl;
+        return ObjData();
+    }
+    ssize_t read = pread(fd, bytes.data(), bytes.size(), entry.begin);
+    close(fd);
+    if (read != (ssize_t)bytes.size())
+    {
+        std::cerr << "Could not read object " << entry.name << " from " << _path << std::endl;
+        return ObjData();
+    }
+
+    ObjData data = parseObj(bytes.data(), bytes.data() + bytes.size(), 0, entry.before);
+    if (!data.objects.empty() && isSelfContained(data)) return extractObject(data, data.objects.front());
+
+    // Faces using elements listed before their object. Rare, but valid OBJ: parse everything up to the object instead.
+    MappedFile file{_path};
+    if (!file.data) return ObjData();
+    data = parseObj(file.data, file.data + std::min<uint64_t>(entry.end, file.size));
+    if (data.objects.empty()) return ObjData();
+    return extractObject(data, data.objects.back());
+}
+
+std::shared_ptr<const ObjData> ObjLibrary::load(const std::string& name)
+{
+    const ObjIndexEntry* entry = _index.find(name);
+    if (!entry) return std::make_shared<const ObjData>();
+
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        auto cached = _cache.find(name);
+        if (cached != _cache.end())
+        {
+            _recent.splice(_recent.begin(), _recent, cached->second.recent);
+            return cached->second.data;
+        }
+    }
+
+    // Parsed without the lock, so several threads can load different objects at once
+    std::shared_ptr<const ObjData> data = std::make_shared<const ObjData>(parse(*entry));
+
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto [cached, added] = _cache.try_emplace(name);
+    if (!added) return cached->second.data;     // Another thread got there first
+
+    _recent.push_front(name);
+    cached->second = {data, memoryUsed(*data), _recent.begin()};
+    _used += cached->second.bytes;
+    evict();
+    return data;
+}
+
+void ObjLibrary::setMemoryBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    _budget = bytes;
+    evict();
+}
+
+void ObjLibrary::evict()
+{
+    while (_used > _budget && !_recent.empty())
+    {
+        auto cached = _cache.find(_recent.back());
+        _used -= cached->second.bytes;
+        _cache.erase(cached);
+        _recent.pop_back();
+    }
+}
@@ -0,0 +1,296 @@
+#include "ObjLoader.h"
+#include <charconv>
+#include <cstring>
+#include <thread>
+
+// Chunks smaller than this are not worth a thread of their own
+const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+const char* findLineEnd(const char* p, const char* end)
+{
+    if (p >= end) return end;
+    const char* newline = (const char*)std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return newline ? newline : end;
+}
+
+namespace
+{
+    // What one thread parsed from its chunk of the file
+    struct Chunk
+    {
+        const char* begin;
+        const char* end;
+
+        std::vector<Vec3f> positions;
+        std::vector<Vec2f> texcoords;
+        std::vector<Vec3f> normals;
+        std::vector<ObjCorner> corners;
+        std::vector<ObjObject> objects;     // firstTriangle is relative to the chunk
+
+        // Corners with negative (relative) indices can only be resolved to a chunk local index, since the number of
+        // vertices in earlier chunks is not known yet. These are the corner and which of v/vt/vn (0/1/2) to fix up.
+        std::vector<std::pair<size_t, uint8_t>> relative;
+
+        // Elements of the file before the parsed part, which absolute indices count
+        ObjCounts before;
+
+        // Where this chunk's data starts in the merged arrays
+        size_t positionBase = 0, texcoordBase = 0, normalBase = 0, cornerBase = 0;
+    };
+
+    void skipSpaces(const char*& p, const char* end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+    }
+
+    void skipLine(const char*& p, const char* end)
+    {
+        p = findLineEnd(p, end);
+        if (p < end) p++;
+    }
+
+    bool atLineEnd(const char* p, const char* end) { return p >= end || *p == '\n' || *p == '\r' || *p == '#'; }
+
+    float parseFloat(const char*& p, const char* end)
+    {
+        skipSpaces(p, end);
+        float value = 0;
+        if (p < end && *p == '+') p++;      // from_chars does not accept a leading plus
+        auto [next, error] = std::from_chars(p, end, value);
+        p = next;
+        return value;
+    }
+
+    // Turns an OBJ index (from 1, or negative counting back from the latest element) into an index from 0, counting from
+    // the start of the parsed part which has `before` elements ahead of it. Returns true if it is relative to the start of the chunk.
+    bool resolveIndex(long raw, size_t localCount, uint32_t before, int32_t& index)
+    {
+        if (raw > 0)
+        {
+            index = raw > before ? (int32_t)(raw - 1 - before) : OBJ_INDEX_BEFORE;
+            return false;
+        } else if (raw < 0)
+        {
+            index = (int32_t)((long)localCount + raw);
+            return true;
+        }
+        index = -1;
+        return false;
+    }
+
+    void parseChunk(Chunk& chunk)
+    {
+        const char* p = chunk.begin;
+        const char* end = chunk.end;
+        std::vector<ObjCorner> face;
+        std::vector<uint8_t> faceRelative;
+
+        while (p < end)
+        {
+            skipSpaces(p, end);
+            if (atLineEnd(p, end))
+            {
+                skipLine(p, end);
+                continue;
+            }
+
+            const char* keyword = p;
+            while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') p++;
+            size_t length = p - keyword;
+
+            if (length == 1 && keyword[0] == 'v')
+            {
+                float x = parseFloat(p, end);
+                float y = parseFloat(p, end);
+                float z = parseFloat(p, end);
+                chunk.positions.emplace_back(x, y, z);
+            } else if (length == 2 && keyword[0] == 'v' && keyword[1] == 't')
+            {
+                float u = parseFloat(p, end);
+                float v = parseFloat(p, end);
+                chunk.texcoords.emplace_back(u, v);
+            } else if (length == 2 && keyword[0] == 'v' && keyword[1] == 'n')
+            {
+                float x = parseFloat(p, end);
+                float y = parseFloat(p, end);
+                float z = parseFloat(p, end);
+                chunk.normals.emplace_back(x, y, z);
+            } else if (length == 1 && keyword[0] == 'f')
+            {
+                // Corners are v, v/vt, v//vn or v/vt/vn
+                face.clear();
+                faceRelative.clear();
+                while (true)
+                {
+                    skipSpaces(p, end);
+                    if (atLineEnd(p, end)) break;
+
+                    ObjCorner corner;
+                    uint8_t relative = 0;
+                    long raw = 0;
+                    auto [next, error] = std::from_chars(p, end, raw);
+                    if (error != std::errc()) break;
+                    p = next;
+                    if (resolveIndex(raw, chunk.positions.size(), chunk.before.positions, corner.v)) relative |= 1;
+
+                    if (p < end && *p == '/')
+                    {
+                        p++;
+                        if (p < end && *p != '/')
+                        {
+                            auto [next, error] = std::from_chars(p, end, raw);
+                            p = next;
+                            if (error == std::errc() && resolveIndex(raw, chunk.texcoords.size(), chunk.before.texcoords, corner.vt)) relative |= 2;
+                        }
+                        if (p < end && *p == '/')
+                        {
+                            p++;
+                            auto [next, error] = std::from_chars(p, end, raw);
+                            p = next;
+                            if (error == std::errc() && resolveIndex(raw, chunk.normals.size(), chunk.before.normals, corner.vn)) relative |= 4;
+                        }
+                    }
+
+                    face.push_back(corner);
+                    faceRelative.push_back(relative);
+                }
+
+                // Split into a fan of triangles around the first corner
+                for (size_t i{1}; i + 1 < face.size(); ++i)
+                {
+                    for (size_t k : {(size_t)0, i, i + 1})
+                    {
+                        for (uint8_t component{0}; component < 3; ++component)
+                        {
+                            if (faceRelative[k] & (1 << component)) chunk.relative.emplace_back(chunk.corners.size(), component);
+                        }
+                        chunk.corners.push_back(face[k]);
+                    }
+                }
+            } else if (length == 1 && keyword[0] == 'o')
+            {
+                skipSpaces(p, end);
+                const char* name = p;
+                const char* nameEnd = findLineEnd(p, end);
+                while (nameEnd > name && (nameEnd[-1] == '\r' || nameEnd[-1] == ' ' || nameEnd[-1] == '\t')) nameEnd--;
+
+                ObjObject object;
+                object.name.assign(name, nameEnd);
+                object.firstTriangle = chunk.corners.size() / 3;
+                chunk.objects.push_back(object);
+            }
+
+            // Anything else (comments, materials, groups, smoothing) is ignored
+            skipLine(p, end);
+        }
+    }
+
+    // Runs job(i) for every i in [0, count) with one thread each
+    template<typename Job>
+    void parallelFor(size_t count, Job job)
+    {
+        if (count == 1)
+        {
+            job(0);
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(count);
+        for (size_t i{0}; i < count; ++i) { threads.emplace_back(job, i); }
+        for (auto& thread : threads) { thread.join(); }
+    }
+}
+
+const ObjObject* ObjData::findObject(const std::string& name) const
+{
+    for (const auto& object : objects)
+    {
+        if (object.name == name) return &object;
+    }
+    return nullptr;
+}
+
+ObjData parseObj(const char* begin, const char* end, unsigned threads, ObjCounts before)
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Split into chunks that end just after a newline, so no record is cut in two
+    size_t size = end - begin;
+    size_t chunkCount = std::max((size_t)1, std::min((size_t)threads, size / MIN_CHUNK_SIZE));
+
+    std::vector<Chunk> chunks(chunkCount);
+    const char* chunkBegin = begin;
+    for (size_t i{0}; i < chunkCount; ++i)
+    {
+        const char* chunkEnd = (i + 1 == chunkCount) ? end : std::max(chunkBegin, begin + size * (i + 1) / chunkCount);
+        if (chunkEnd < end) skipLine(chunkEnd, end);
+
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunks[i].before = before;
+        chunkBegin = chunkEnd;
+    }
+
+    parallelFor(chunkCount, [&](size_t i) { parseChunk(chunks[i]); });
+
+    // Every chunk's data goes after the data of the chunks before it
+    ObjData data;
+    size_t positions = 0, texcoords = 0, normals = 0, corners = 0;
+    for (Chunk& chunk : chunks)
+    {
+        chunk.positionBase = positions;
+        chunk.texcoordBase = texcoords;
+        chunk.normalBase = normals;
+        chunk.cornerBase = corners;
+        positions += chunk.positions.size();
+        texcoords += chunk.texcoords.size();
+        normals += chunk.normals.size();
+        corners += chunk.corners.size();
+
+        for (ObjObject object : chunk.objects)
+        {
+            object.firstTriangle += chunk.cornerBase / 3;
+            data.objects.push_back(object);
+        }
+    }
+
+    data.positions.resize(positions);
+    data.texcoords.resize(texcoords);
+    data.normals.resize(normals);
+    data.corners.resize(corners);
+
+    parallelFor(chunkCount, [&](size_t i)
+    {
+        Chunk& chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), data.positions.begin() + chunk.positionBase);
+        std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), data.texcoords.begin() + chunk.texcoordBase);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), data.normals.begin() + chunk.normalBase);
+
+        for (const auto& [corner, component] : chunk.relative)
+        {
+            ObjCorner& c = chunk.corners[corner];
+            int32_t& index = component == 0 ? c.v : component == 1 ? c.vt : c.vn;
+            index += component == 0 ? chunk.positionBase : component == 1 ? chunk.texcoordBase : chunk.normalBase;
+
+            // Counted back past the start of the parsed part
+            if (index < 0) index = OBJ_INDEX_BEFORE;
+        }
+        std::copy(chunk.corners.begin(), chunk.corners.end(), data.corners.begin() + chunk.cornerBase);
+    });
+
+    // Triangles before the first "o" record still belong to an object
+    uint32_t triangleCount = data.corners.size() / 3;
+    if (triangleCount > 0 && (data.objects.empty() || data.objects.front().firstTriangle > 0))
+    {
+        data.objects.insert(data.objects.begin(), ObjObject{"default", 0, 0});
+    }
+
+    for (size_t i{0}; i < data.objects.size(); ++i)
+    {
+        uint32_t next = (i + 1 < data.objects.size()) ? data.objects[i + 1].firstTriangle : triangleCount;
+        data.objects[i].triangleCount = next - data.objects[i].firstTriangle;
+    }
+
+    return data;
+}
@@ -0,0 +1,122 @@
+#include "OcclusionBuffer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const uint16_t FULL_MASK = 0xFFFF;
+
+// Pixel centres this close to an edge, in pixels, are not counted as covered, as the rasterizer walking the edge
+// incrementally may round them the other way
+const float EDGE_MARGIN = 1e-3f;
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height) :
+    _cellsX{int32_t(width + CELL_SIZE - 1) / CELL_SIZE}, _cellsY{int32_t(height + CELL_SIZE - 1) / CELL_SIZE}, _width{width}, _height{height}
+{
+    _cells.resize(_cellsX * _cellsY);
+}
+
+uint16_t OcclusionBuffer::outsideMask(int32_t cx, int32_t cy) const
+{
+    uint16_t mask = 0;
+    for (int32_t j{0}; j < CELL_SIZE; ++j)
+    {
+        for (int32_t i{0}; i < CELL_SIZE; ++i)
+        {
+            if (cx * CELL_SIZE + i >= (int32_t)_width || cy * CELL_SIZE + j >= (int32_t)_height) mask |= 1 << (j * CELL_SIZE + i);
+        }
+    }
+    return mask;
+}
+
+void OcclusionBuffer::clear(float depth)
+{
+    for (int32_t cy{0}; cy < _cellsY; ++cy)
+    {
+        for (int32_t cx{0}; cx < _cellsX; ++cx) { _cells[cy * _cellsX + cx] = {depth, outsideMask(cx, cy), -std::numeric_limits<float>::max()}; }
+    }
+}
+
+void OcclusionBuffer::drawTriangles(const std::vector<RasterVertex<0>>& vertices, const std::vector<uint32_t>& indices, float near, float far)
+{
+    const Rect image{0, 0, int32_t(_width) - 1, int32_t(_height) - 1};
+
+    for (size_t t{0}; t + 2 < indices.size(); t += 3)
+    {
+        const RasterVertex<0>& v0 = vertices[indices[t]];
+        const RasterVertex<0>& v1 = vertices[indices[t + 1]];
+        const RasterVertex<0>& v2 = vertices[indices[t + 2]];
+
+        // Raster depth is minus the camera space z (see convertToRaster())
+        float maxDepth = std::max(std::max(v0.z, v1.z), v2.z);
+        float minDepth = std::min(std::min(v0.z, v1.z), v2.z);
+        if (maxDepth > -near || minDepth < -far) continue;
+
+        TriangleSetup<0> triangle;
+        if (!triangle.setupEdges(v0, v1, v2, image)) continue;
+        triangle.setupInterpolation(v0, v1, v2);
+
+        float margins[3];
+        for (int e{0}; e < 3; ++e) { margins[e] = EDGE_MARGIN * std::hypot(triangle.edges[e].a, triangle.edges[e].b); }
+
+        for (int32_t cy{triangle.y0 / CELL_SIZE}; cy <= triangle.y1 / CELL_SIZE; ++cy)
+        {
+            for (int32_t cx{triangle.x0 / CELL_SIZE}; cx <= triangle.x1 / CELL_SIZE; ++cx)
+            {
+                uint16_t covered = 0;
+                for (int32_t j{0}; j < CELL_SIZE; ++j)
+                {
+                    float py = cy * CELL_SIZE + j + 0.5f;
+                    for (int32_t i{0}; i < CELL_SIZE; ++i)
+                    {
+                        float px = cx * CELL_SIZE + i + 0.5f;
+                        if (triangle.edges[0].at(px, py) >= margins[0] && triangle.edges[1].at(px, py) >= margins[1] &&
+                            triangle.edges[2].at(px, py) >= margins[2]) covered |= 1 << (j * CELL_SIZE + i);
+                    }
+                }
+                if (!covered) continue;
+
+                // The depth is 1 / the interpolated 1/z, which only grows as 1/z gets smaller. So the largest depth in the cell
+                // is at the corner where 1/z is smallest, unless that corner is far enough outside the triangle for the plane
+                // to change sign, where the vertices' largest depth still bounds it.
+                float x0 = cx * CELL_SIZE, y0 = cy * CELL_SIZE, x1 = x0 + CELL_SIZE, y1 = y0 + CELL_SIZE;
+                float minOneOverZ = std::min(std::min(triangle.depth.at(x0, y0), triangle.depth.at(x1, y0)),
+                                             std::min(triangle.depth.at(x0, y1), triangle.depth.at(x1, y1)));
+                float depth = minOneOverZ < 0 ? std::min(1 / minOneOverZ, maxDepth) : maxDepth;
+                depth += std::abs(depth) * 1e-5f;
+
+                Cell& cell = _cells[cy * _cellsX + cx];
+                if (!(depth < cell.depth)) continue;
+
+                if ((covered | outsideMask(cx, cy)) == FULL_MASK)
+                {
+                    cell.depth = depth;
+                    continue;
+                }
+
+                cell.mask |= covered;
+                cell.maskDepth = std::max(cell.maskDepth, depth);
+                if (cell.mask == FULL_MASK)
+                {
+                    cell.depth = std::min(cell.depth, cell.maskDepth);
+                    cell.mask = outsideMask(cx, cy);
+                    cell.maskDepth = -std::numeric_limits<float>::max();
+                }
+            }
+        }
+    }
+}
+
+bool OcclusionBuffer::isHidden(const Rect& rect, float nearest) const
+{
+    if (rect.empty()) return true;
+
+    for (int32_t cy{rect.y0 / CELL_SIZE}; cy <= rect.y1 / CELL_SIZE; ++cy)
+    {
+        for (int32_t cx{rect.x0 / CELL_SIZE}; cx <= rect.x1 / CELL_SIZE; ++cx)
+        {
+            // Strictly behind, as LESS_EQUAL lets equal depths through
+            if (!(nearest > _cells[cy * _cellsX + cx].depth)) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,341 @@
+#include "RenderServer.h"
+#include "ObjLibrary.h"
+#include <fstream>
+#include <sstream>
+
+RenderServer::RenderServer(uint32_t width, uint32_t height) : renderer{width, height}, _scaler{width, height} {}
+
+void RenderServer::run(std::istream& in, std::ostream& out)
+{
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (!execute(line, out)) break;
+    }
+}
+
+// Resolution of the shadow map, on each side
+const uint32_t SHADOW_MAP_SIZE = 1024;
+
+// Reads three integers in [0, 255] as a colour
+static bool readColour(std::istringstream& iss, Colour& colour)
+{
+    int r, g, b;
+    if (!(iss >> r >> g >> b)) return false;
+    if (r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255) return false;
+
+    colour = Colour(r, g, b);
+    return true;
+}
+
+bool RenderServer::execute(const std::string& line, std::ostream& out)
+{
+    std::istringstream iss{line};
+    std::string command;
+
+    // Blank lines are ignored
+    if (!(iss >> command)) return true;
+
+    if (command == "quit")
+    {
+        out << "ok" << std::endl;
+        return false;
+    } else if (command == "load")
+    {
+        std::string name;
+        if (!(iss >> name))
+        {
+            out << "error expected: load <name> [r g b]" << std::endl;
+            return true;
+        }
+
+        Colour colour;
+        if (!(iss >> std::ws).eof() && !readColour(iss, colour))
+        {
+            out << "error invalid colour" << std::endl;
+            return true;
+        }
+
+        if (scene.find(name))
+        {
+            out << "error " << name << " is already loaded" << std::endl;
+            return true;
+        }
+
+        std::shared_ptr<Cube> cube = std::make_shared<Cube>(name, colour);
+        if (cube->triangles.empty())
+        {
+            out << "error no object named " << name << std::endl;
+            return true;
+        }
+
+        scene.add(cube);
+        out << "ok" << std::endl;
+    } else if (command == "budget")
+    {
+        size_t megabytes;
+        if (!(iss >> megabytes))
+        {
+            out << "error expected: budget <megabytes>" << std::endl;
+            return true;
+        }
+
+        ObjLibrary::open(OBJ_FILE)->setMemoryBudget(megabytes << 20);
+        out << "ok" << std::endl;
+    } else if (command == "camera")
+    {
+        Vec3f pos, rot;
+        if (!(iss >> pos.x >> pos.y >> pos.z >> rot.x >> rot.y >> rot.z))
+        {
+            out << "error expected: camera <x> <y> <z> <rx> <ry> <rz>" << std::endl;
+            return true;
+        }
+
+        camera.position = pos;
+        camera.rotation = rot;
+        out << "ok" << std::endl;
+    } else if (command == "colour")
+    {
+        std::string name;
+        Colour colour;
+        if (!(iss >> name) || !readColour(iss, colour))
+        {
+            out << "error expected: colour <name> <r> <g> <b>" << std::endl;
+            return true;
+        }
+
+        std::shared_ptr<Cube> cube = std::dynamic_pointer_cast<Cube>(scene.find(name));
+        if (!cube)
+        {
+            out << "error no object named " << name << std::endl;
+            return true;
+        }
+
+        cube->setColour(colour);
+        out << "ok" << std::endl;
+    } else if (command == "move")
+    {
+        std::string name;
+        Vec3f offset;
+        if (!(iss >> name >> offset.x >> offset.y >> offset.z))
+        {
+            out << "error expected: move <name> <dx> <dy> <dz>" << std::endl;
+            return true;
+        }
+
+        std::shared_ptr<SceneObject> sceneObj = scene.find(name);
+        if (!sceneObj)
+        {
+            out << "error no object named " << name << std::endl;
+            return true;
+        }
+
+        sceneObj->translate(offset);
+        scene.refit(*sceneObj);
+        out << "ok" << std::endl;
+    } else if (command == "depth")
+    {
+        std::string test, write;
+        if (!(iss >> test >> write) || (test != "on" && test != "off") || (write != "on" && write != "off"))
+        {
+            out << "error expected: depth <on|off> <on|off>" << std::endl;
+            return true;
+        }
+
+        renderer.depthTest = test == "on";
+        renderer.depthWrite = write == "on";
+        out << "ok" << std::endl;
+    } else if (command == "blend")
+    {
+        std::string mode;
+        iss >> mode;
+        if (mode == "replace") renderer.blendMode = BlendMode::REPLACE;
+        else if (mode == "add") renderer.blendMode = BlendMode::ADD;
+        else if (mode == "average") renderer.blendMode = BlendMode::AVERAGE;
+        else
+        {
+            out << "error expected: blend <replace|add|average>" << std::endl;
+            return true;
+        }
+        out << "ok" << std::endl;
+    } else if (command == "prepass")
+    {
+        std::string state;
+        iss >> state;
+        if (state != "on" && state != "off")
+        {
+            out << "error expected: prepass <on|off>" << std::endl;
+            return true;
+        }
+
+        renderer.depthPrepass = state == "on";
+        out << "ok" << std::endl;
+    } else if (command == "incremental")
+    {
+        std::string state;
+        iss >> state;
+        if (state != "on" && state != "off")
+        {
+            out << "error expected: incremental <on|off>" << std::endl;
+            return true;
+        }
+
+        renderer.incremental = state == "on";
+        out << "ok" << std::endl;
+    } else if (command == "occlusion")
+    {
+        std::string state;
+        iss >> state;
+        if (state != "on" && state != "off")
+        {
+            out << "error expected: occlusion <on|off>" << std::endl;
+            return true;
+        }
+
+        renderer.occlusionCulling = state == "on";
+        out << "ok" << std::endl;
+    } else if (command == "light")
+    {
+        std::string type;
+        iss >> type;
+        if (type == "clear")
+        {
+            scene.lighting.lights.clear();
+            out << "ok" << std::endl;
+            return true;
+        }
+
+        Light light;
+        Vec3f vector;
+        if ((type != "directional" && type != "point") || !(iss >> vector.x >> vector.y >> vector.z))
+        {
+            out << "error expected: light directional <dx> <dy> <dz> [r g b], light point <x> <y> <z> [r g b] or light clear" << std::endl;
+            return true;
+        }
+
+        // The colour is optional, white otherwise
+        Colour colour(255);
+        if (!(iss >> std::ws).eof() && !readColour(iss, colour))
+        {
+            out << "error invalid colour" << std::endl;
+            return true;
+        }
+
+        light.colour = Vec3f(colour.x / 255.0f, colour.y / 255.0f, colour.z / 255.0f);
+
+        light.type = type == "directional" ? Light::DIRECTIONAL : Light::POINT;
+        (light.type == Light::DIRECTIONAL ? light.direction : light.position) = vector;
+        scene.lighting.lights.push_back(light);
+        out << "ok" << std::endl;
+    } else if (command == "lighting")
+    {
+        std::string mode;
+        iss >> mode;
+        if (mode != "vertex" && mode != "pixel")
+        {
+            out << "error expected: lighting <vertex|pixel>" << std::endl;
+            return true;
+        }
+
+        renderer.perPixelLighting = mode == "pixel";
+        out << "ok" << std::endl;
+    } else if (command == "stats")
+    {
+        const OcclusionStats& stats = renderer.getOcclusionStats();
+        out << "ok " << stats.occluders << " " << stats.tested << " " << stats.hidden << std::endl;
+    } else if (command == "shadow")
+    {
+        std::string first;
+        iss >> first;
+        if (first == "off")
+        {
+            _shadowMap.reset();
+            renderer.shadowMap = nullptr;
+            out << "ok" << std::endl;
+            return true;
+        }
+
+        Vec3f pos, rot;
+        std::istringstream position{first};
+        if (!(position >> pos.x) || !(iss >> pos.y >> pos.z >> rot.x >> rot.y >> rot.z))
+        {
+            out << "error expected: shadow <x> <y> <z> <rx> <ry> <rz> or shadow off" << std::endl;
+            return true;
+        }
+
+        _shadowMap = std::make_unique<ShadowMap>(Camera{pos, rot}, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+        renderer.shadowMap = _shadowMap.get();
+        out << "ok" << std::endl;
+    } else if (command == "frametime")
+    {
+        std::string first;
+        if (!(iss >> first))
+        {
+            out << "ok " << _scaler.getRenderWidth() << " " << _scaler.getRenderHeight() << " " << _scaler.getLastMilliseconds() << std::endl;
+            return true;
+        }
+
+        if (first == "off")
+        {
+            _scaler.targetMilliseconds = 0;
+            renderer.resize(_scaler.getWidth(), _scaler.getHeight());
+            out << "ok" << std::endl;
+            return true;
+        }
+
+        float milliseconds;
+        std::istringstream value{first};
+        if (!(value >> milliseconds) || milliseconds <= 0)
+        {
+            out << "error expected: frametime <milliseconds>, frametime off or frametime" << std::endl;
+            return true;
+        }
+
+        _scaler.targetMilliseconds = milliseconds;
+        out << "ok" << std::endl;
+    } else if (command == "render")
+    {
+        std::string path;
+        if (!(iss >> path))
+        {
+            out << "error expected: render <path|->" << std::endl;
+            return true;
+        }
+
+        if (_shadowMap) renderer.renderShadowMap(scene, *_shadowMap);
+
+        // Frames are upscaled to the full resolution when rendered smaller
+        const bool scaled = _scaler.targetMilliseconds > 0;
+        if (scaled) _scaler.render(renderer, camera, scene);
+        else renderer.render(camera, scene);
+
+        auto writePPM = [&](std::ostream& os) { if (scaled) _scaler.writePPM(os); else renderer.writePPM(os); };
+
+        if (path == "-")
+        {
+            std::ostringstream image;
+            writePPM(image);
+
+            const std::string data = image.str();
+            out << "ok " << data.size() << "\n";
+            out.write(data.data(), data.size());
+            out.flush();
+        } else
+        {
+            std::ofstream ofs{path, std::ios::binary};
+            if (!ofs.is_open())
+            {
+                out << "error could not open " << path << std::endl;
+                return true;
+            }
+
+            writePPM(ofs);
+            out << "ok" << std::endl;
+        }
+    } else
+    {
+        out << "error unknown command " << command << std::endl;
+    }
+
+    return true;
+}
@@ -0,0 +1,499 @@
+#include "Renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+Renderer::Renderer(uint32_t width, uint32_t height) : 
+    frameBuffer(width * height), zBuffer(width * height), _tiles{width, height}, _occlusion{width, height}, _width{width}, _height{height} {}
+
+uint32_t Renderer::getWidth() const { return _width; }
+uint32_t Renderer::getHeight() const { return _height; }
+
+void Renderer::clear(Colour colour, float depth)
+{
+    _tiles.clear(colour, depth);
+}
+
+void Renderer::resolveDepth()
+{
+    _tiles.resolve(RenderTarget{frameBuffer.data(), zBuffer.data(), _width, _height}, true);
+}
+
+void Renderer::resize(uint32_t width, uint32_t height)
+{
+    if (width == _width && height == _height) return;
+
+    _width = width;
+    _height = height;
+    frameBuffer.assign(width * height, Colour());
+    zBuffer.assign(width * height, 0);
+    _tiles = TileClear{width, height};
+    _occlusion = OcclusionBuffer{width, height};
+
+    // The last frame's screen rectangles mean nothing at the new resolution
+    _drawn.clear();
+    _hasLastFrame = false;
+}
+
+bool Renderer::FrameState::operator==(const FrameState& other) const
+{
+    auto same = [](const auto& a, const auto& b) { return a.x == b.x && a.y == b.y && a.z == b.z; };
+
+    return same(camera.position, other.camera.position) && same(camera.rotation, other.camera.rotation) && 
+        camera.focalLength == other.camera.focalLength && 
+        camera.filmApertureWidth == other.camera.filmApertureWidth && camera.filmApertureHeight == other.camera.filmApertureHeight &&
+        camera.nearClippingPlane == other.camera.nearClippingPlane && camera.farClippingPlane == other.camera.farClippingPlane &&
+        same(background, other.background) &&
+        depthTest == other.depthTest && depthWrite == other.depthWrite && depthPrepass == other.depthPrepass && 
+        blendMode == other.blendMode && shadows == other.shadows && lighting == other.lighting && perPixelLighting == other.perPixelLighting;
+}
+
+const std::vector<Rect>& Renderer::getDirtyRects() const { return _dirtyRects; }
+
+const OcclusionStats& Renderer::getOcclusionStats() const { return _occlusionStats; }
+
+// Objects drawn into the occlusion buffer, picked from the largest on screen down
+const size_t MAX_OCCLUDERS = 8;
+
+void Renderer::render(const Camera& camera, Scene& scene)
+{
+    const View view{camera, _width, _height};
+
+    const Frustum frustum{camera};
+    _visible.clear();
+    scene.cull(frustum, _visible);
+
+    _visibleBounds.clear();
+    for (const auto& sceneObj : _visible) { _visibleBounds.push_back(view.screenBounds(sceneObj->getBounds())); }
+
+    _occlusionStats = {};
+    if (occlusionCulling && depthTest && depthWrite && blendMode == BlendMode::REPLACE) cullOccluded(view);
+
+    const FrameState frame{camera, background, depthTest, depthWrite, depthPrepass, blendMode, shadowMap != nullptr, scene.lighting, perPixelLighting};
+    RenderTarget target{frameBuffer.data(), zBuffer.data(), _width, _height};
+    target.tiles = &_tiles;
+
+    if (incremental && _hasLastFrame && !frame.shadows && frame == _lastFrame)
+    {
+        findDirtyRects();
+
+        for (const Rect& rect : _dirtyRects)
+        {
+            for (int32_t y{rect.y0}; y <= rect.y1; ++y)
+            {
+                std::fill_n(frameBuffer.begin() + y * _width + rect.x0, rect.x1 - rect.x0 + 1, background);
+                std::fill_n(zBuffer.begin() + y * _width + rect.x0, rect.x1 - rect.x0 + 1, camera.farClippingPlane);
+            }
+
+            target.scissor = rect;
+            drawVisible(view, frustum, target, scene.lighting);
+        }
+    } else
+    {
+        clear(background, camera.farClippingPlane);
+        drawVisible(view, frustum, target, scene.lighting);
+
+        _tiles.resolve(target);
+        _dirtyRects.assign(1, target.scissor);
+    }
+
+    rememberFrame(frame);
+}
+
+void Renderer::render(const Camera& camera, Scene& scene, SceneLoader& loader)
+{
+    // Without depth test and writes, or when blending, every object drawn changes the pixels under it rather than only
+    // the ones it is in front of, so those frames are left to a normal render
+    if (!(depthTest && depthWrite && blendMode == BlendMode::REPLACE))
+    {
+        loader.finish(scene);
+        render(camera, scene);
+        return;
+    }
+
+    const View view{camera, _width, _height};
+    const Frustum frustum{camera};
+
+    const FrameState frame{camera, background, depthTest, depthWrite, depthPrepass, blendMode, shadowMap != nullptr, scene.lighting, perPixelLighting};
+    RenderTarget target{frameBuffer.data(), zBuffer.data(), _width, _height};
+    target.tiles = &_tiles;
+
+    clear(background, camera.farClippingPlane);
+    _occlusionStats = {};
+
+    // The objects the scene already holds are drawn first, as a normal frame would
+    _visible.clear();
+    scene.cull(frustum, _visible);
+    _visibleBounds.clear();
+    for (const auto& sceneObj : _visible) { _visibleBounds.push_back(view.screenBounds(sceneObj->getBounds())); }
+    drawVisible(view, frustum, target, scene.lighting);
+
+    // Then every object as soon as it is loaded. The loader hands them over in the order of their jobs, the order a
+    // normal frame would draw them in, so ties in depth go the same way. They are drawn one at a time, so there is no
+    // depth prepass or occlusion culling for them, but the image is the same.
+    while (std::shared_ptr<SceneObject> sceneObj = loader.next())
+    {
+        scene.add(sceneObj);
+        if (frustum.classify(sceneObj->getBounds()) == Frustum::OUTSIDE) continue;
+
+        _visible.push_back(sceneObj);
+        _visibleBounds.push_back(view.screenBounds(sceneObj->getBounds()));
+        drawShaded(*sceneObj, view, frustum, target, scene.lighting, DepthTest::LESS);
+    }
+
+    _tiles.resolve(target);
+    _dirtyRects.assign(1, target.scissor);
+
+    rememberFrame(frame);
+}
+
+void Renderer::rememberFrame(const FrameState& frame)
+{
+    _drawn.clear();
+    for (size_t i{0}; i < _visible.size(); ++i) { _drawn[_visible[i].get()] = {_visibleBounds[i], _visible[i]->getVersion()}; }
+    _lastFrame = frame;
+    _hasLastFrame = true;
+}
+
+void Renderer::findDirtyRects()
+{
+    _dirtyRects.clear();
+
+    // Changed objects have to be erased where they were and drawn where they are now
+    std::unordered_map<const SceneObject*, DrawnObject> gone = _drawn;
+    for (size_t i{0}; i < _visible.size(); ++i)
+    {
+        auto drawn = gone.find(_visible[i].get());
+        if (drawn == gone.end())
+        {
+            _dirtyRects.push_back(_visibleBounds[i]);
+            continue;
+        }
+
+        if (drawn->second.version != _visible[i]->getVersion() || !(drawn->second.bounds == _visibleBounds[i]))
+        {
+            _dirtyRects.push_back(drawn->second.bounds);
+            _dirtyRects.push_back(_visibleBounds[i]);
+        }
+        gone.erase(drawn);
+    }
+    for (const auto& [sceneObj, drawn] : gone) { _dirtyRects.push_back(drawn.bounds); }
+
+    std::erase_if(_dirtyRects, [](const Rect& rect) { return rect.empty(); });
+
+    // Overlapping rectangles would draw the pixels they share twice, which blending would show. Merging them can make a
+    // new overlap, so keep going until there are none.
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (size_t i{0}; i < _dirtyRects.size() && !merged; ++i)
+        {
+            for (size_t j{i + 1}; j < _dirtyRects.size(); ++j)
+            {
+                if (!_dirtyRects[i].overlaps(_dirtyRects[j])) continue;
+
+                _dirtyRects[i] = _dirtyRects[i].merged(_dirtyRects[j]);
+                _dirtyRects.erase(_dirtyRects.begin() + j);
+                merged = true;
+                break;
+            }
+        }
+    }
+}
+
+void Renderer::drawVisible(const View& view, const Frustum& frustum, const RenderTarget& target, const Lighting& lighting)
+{
+    DepthTest test = depthTest ? DepthTest::LESS : DepthTest::OFF;
+
+    if (depthPrepass && depthTest)
+    {
+        DrawFunction<DepthOnlyShader> draw = selectPipeline<DepthOnlyShader>(DepthTest::LESS, true, BlendMode::REPLACE);
+        for (size_t i{0}; i < _visible.size(); ++i)
+        {
+            if (_visibleBounds[i].overlaps(target.scissor)) drawObject(*_visible[i], view, frustum, DepthOnlyShader{}, target, draw, true);
+        }
+
+        // The prepass wrote the same depths the shading pass computes, so the surfaces in front pass on equal depth. The
+        // rasterizer has no fill rule though, and a pixel on the edge two triangles share passes for both: it is shaded
+        // twice and keeps the later triangle, where without the prepass it keeps the earlier one. Such edge pixels can
+        // differ slightly from a frame drawn without the prepass.
+        test = DepthTest::LESS_EQUAL;
+    }
+
+    for (size_t i{0}; i < _visible.size(); ++i)
+    {
+        if (_visibleBounds[i].overlaps(target.scissor)) drawShaded(*_visible[i], view, frustum, target, lighting, test);
+    }
+}
+
+void Renderer::drawShaded(const SceneObject& sceneObj, const View& view, const Frustum& frustum, const RenderTarget& target, 
+                          const Lighting& lighting, DepthTest test)
+{
+    // Lit per vertex unless asked for per pixel lighting, and not at all without lights
+    const bool lit = !lighting.lights.empty();
+    const Lighting* vertexLighting = lit && !perPixelLighting ? &lighting : nullptr;
+
+    if (lit && perPixelLighting)
+    {
+        PerPixelLightingShader shader{&lighting, view.camera.position, shadowMap};
+        drawObject(sceneObj, view, frustum, shader, target, selectPipeline<PerPixelLightingShader>(test, depthWrite, blendMode), depthTest);
+    } else if (shadowMap)
+    {
+        ShadowedColourShader shader{shadowMap};
+        drawObject(sceneObj, view, frustum, shader, target, selectPipeline<ShadowedColourShader>(test, depthWrite, blendMode), depthTest, vertexLighting);
+    } else
+    {
+        drawObject(sceneObj, view, frustum, VertexColourShader{}, target, selectPipeline<VertexColourShader>(test, depthWrite, blendMode), depthTest, vertexLighting);
+    }
+}
+
+void Renderer::renderDepth(const Camera& camera, Scene& scene, float* depth, uint32_t width, uint32_t height)
+{
+    const View view{camera, width, height};
+
+    std::fill(depth, depth + width * height, camera.farClippingPlane);
+
+    const Frustum frustum{camera};
+    _visible.clear();
+    scene.cull(frustum, _visible);
+
+    RenderTarget target{nullptr, depth, width, height};
+    DrawFunction<DepthOnlyShader> draw = selectPipeline<DepthOnlyShader>(DepthTest::LESS, true, BlendMode::REPLACE);
+    for (const auto& sceneObj : _visible) { drawObject(*sceneObj, view, frustum, DepthOnlyShader{}, target, draw, true); }
+}
+
+void Renderer::renderShadowMap(Scene& scene, ShadowMap& shadowMap)
+{
+    renderDepth(shadowMap.view.camera, scene, shadowMap.depth.data(), shadowMap.view.width, shadowMap.view.height);
+}
+
+// Approximate width in pixels of the object's bounding sphere on screen
+static float projectedSize(const SceneObject& sceneObj, const View& view)
+{
+    BoundingBox bounds = sceneObj.getBounds();
+    float radius = (bounds.max - bounds.min).length() / 2;
+    float distance = (bounds.centre() - view.camera.position).length();
+
+    // The camera is inside the sphere, so the object can fill the screen
+    if (distance <= radius) return std::numeric_limits<float>::max();
+
+    // Similar triangles again: a length at this distance shrinks by nearClippingPlane / distance on the canvas
+    return (2 * radius * view.camera.nearClippingPlane / distance) / (view.right - view.left) * view.width;
+}
+
+// True if the depth buffer already holds something winning the depth test at every pixel the sphere could cover
+static bool isOccluded(const Vec3f& centre, float radius, const View& view, const RenderTarget& target)
+{
+    BoundingBox box;
+    box.extend(centre - Vec3f(radius));
+    box.extend(centre + Vec3f(radius));
+    Rect rect = view.screenBounds(box);
+    rect = {std::max(rect.x0, target.scissor.x0), std::max(rect.y0, target.scissor.y0), 
+            std::min(rect.x1, target.scissor.x1), std::min(rect.y1, target.scissor.y1)};
+
+    // Raster depth is minus the camera space z (see convertToRaster()), and the smallest depth passes the test
+    Vec3f pCamera;
+    view.worldToCamera.multVecMatrix(centre, pCamera);
+    float smallest = -(pCamera.z + radius);
+
+    for (int32_t y{rect.y0}; y <= rect.y1; ++y)
+    {
+        for (int32_t x{rect.x0}; x <= rect.x1; ++x)
+        {
+            // Tiles waiting to be cleared still hold depths from an older frame
+            if (target.tiles && target.tiles->pending &&
+                target.tiles->states[(y / TileClear::TILE_SIZE) * target.tiles->tilesX + x / TileClear::TILE_SIZE] != TileClear::CLEARED) return false;
+
+            if (!(smallest > target.depth[y * target.width + x])) return false;
+        }
+    }
+    return true;
+}
+
+void Renderer::cullOccluded(const View& view)
+{
+    const Camera& camera = view.camera;
+
+    std::vector<size_t> bySize(_visible.size());
+    for (size_t i{0}; i < bySize.size(); ++i) { bySize[i] = i; }
+    auto area = [&](size_t i) { return _visibleBounds[i].empty() ? 0 : 
+        int64_t(_visibleBounds[i].x1 - _visibleBounds[i].x0 + 1) * (_visibleBounds[i].y1 - _visibleBounds[i].y0 + 1); };
+    std::stable_sort(bySize.begin(), bySize.end(), [&](size_t a, size_t b) { return area(a) > area(b); });
+
+    // Occluders are drawn at the level of detail the frame draws them at, so they cover exactly what they will in the
+    // depth buffer. Simplified levels can shrink inside the mesh and would hide objects that show.
+    _occlusion.clear(camera.farClippingPlane);
+    std::vector<bool> occluder(_visible.size(), false);
+    for (size_t n{0}; n < std::min(MAX_OCCLUDERS, bySize.size()); ++n)
+    {
+        const SceneObject& sceneObj = *_visible[bySize[n]];
+        if (sceneObj.lods.empty()) continue;
+
+        const std::vector<std::shared_ptr<Vertex>>& vertices = sceneObj.getVertices();
+        _occluderVertices.resize(vertices.size());
+        for (size_t i{0}; i < vertices.size(); ++i)
+        {
+            Vertex pRaster;
+            view.toRaster(*vertices[i], pRaster);
+            _occluderVertices[i] = {pRaster.x, pRaster.y, pRaster.z, {}};
+        }
+
+        _occlusion.drawTriangles(_occluderVertices, sceneObj.lods[sceneObj.selectLOD(projectedSize(sceneObj, view))],
+                                 camera.nearClippingPlane, camera.farClippingPlane);
+        occluder[bySize[n]] = true;
+        _occlusionStats.occluders++;
+    }
+
+    size_t kept = 0;
+    for (size_t i{0}; i < _visible.size(); ++i)
+    {
+        bool hidden = false;
+        if (!occluder[i])
+        {
+            // Raster depth is linear in camera space, so the nearest point of the box is one of its corners.
+            // Boxes reaching behind the near plane are never hidden.
+            BoundingBox box = _visible[i]->getBounds();
+            float nearest = std::numeric_limits<float>::max();
+            for (int c{0}; c < 8; ++c)
+            {
+                Vertex pRaster;
+                view.toRaster(Vec3f(c & 1 ? box.max.x : box.min.x, c & 2 ? box.max.y : box.min.y, c & 4 ? box.max.z : box.min.z), pRaster);
+                if (pRaster.z > -camera.nearClippingPlane)
+                {
+                    nearest = -std::numeric_limits<float>::max();
+                    break;
+                }
+                nearest = std::min(nearest, pRaster.z);
+            }
+
+            hidden = _occlusion.isHidden(_visibleBounds[i], nearest);
+            _occlusionStats.tested++;
+            _occlusionStats.hidden += hidden;
+        }
+
+        if (hidden) continue;
+        _visible[kept] = _visible[i];
+        _visibleBounds[kept] = _visibleBounds[i];
+        kept++;
+    }
+    _visible.resize(kept);
+    _visibleBounds.resize(kept);
+}
+
+// Slot of the vertices not lit in the draw, which are not drawn either
+const uint32_t UNLIT = std::numeric_limits<uint32_t>::max();
+
+template<typename SHADER>
+void Renderer::drawObject(const SceneObject& sceneObj, const View& view, const Frustum& frustum, const SHADER& shader, 
+                          const RenderTarget& target, DrawFunction<SHADER> draw, bool occlusionTest, const Lighting* vertexLighting)
+{
+    if (sceneObj.lods.empty()) return;
+
+    const std::vector<std::shared_ptr<Vertex>>& vertices = sceneObj.getVertices();
+
+    // Meshlets are culled first, so that only the vertices of the ones left are lit and transformed. Those in front are
+    // not drawn yet when testing the ones behind them, which only matters without a depth prepass.
+    uint32_t level = sceneObj.selectLOD(projectedSize(sceneObj, view));
+    const bool culled = level == 0 && clusterCulling && !sceneObj.meshlets.empty();
+    _drawnMeshlets.clear();
+    if (culled)
+    {
+        for (const Meshlet& meshlet : sceneObj.meshlets)
+        {
+            if (!frustum.intersects(meshlet.centre, meshlet.radius)) continue;
+            if (meshlet.facesAway(view.camera.position)) continue;
+            if (occlusionTest && isOccluded(meshlet.centre, meshlet.radius, view, target)) continue;
+
+            _drawnMeshlets.push_back(&meshlet);
+        }
+    }
+
+    // Light the vertices drawn in one batch, which is much cheaper per vertex than lighting them one at a time. A vertex
+    // shared by several meshlets is only lit once.
+    if (vertexLighting)
+    {
+        _litVertices.clear();
+        if (culled)
+        {
+            _litSlots.assign(vertices.size(), UNLIT);
+            for (const Meshlet* meshlet : _drawnMeshlets)
+            {
+                for (uint32_t vertex : meshlet->vertices)
+                {
+                    if (_litSlots[vertex] != UNLIT) continue;
+                    _litSlots[vertex] = _litVertices.size();
+                    _litVertices.push_back(vertex);
+                }
+            }
+        } else
+        {
+            _litSlots.resize(vertices.size());
+            _litVertices.resize(vertices.size());
+            std::iota(_litSlots.begin(), _litSlots.end(), 0);
+            std::iota(_litVertices.begin(), _litVertices.end(), 0);
+        }
+
+        _vertexArrays.resize(_litVertices.size());
+        for (size_t i{0}; i < _litVertices.size(); ++i)
+        {
+            const Vertex& vertex = *vertices[_litVertices[i]];
+            _vertexArrays.x[i] = vertex.x;
+            _vertexArrays.y[i] = vertex.y;
+            _vertexArrays.z[i] = vertex.z;
+            _vertexArrays.nx[i] = vertex.normal.x;
+            _vertexArrays.ny[i] = vertex.normal.y;
+            _vertexArrays.nz[i] = vertex.normal.z;
+            _vertexArrays.r[i] = vertex.colour.x;
+            _vertexArrays.g[i] = vertex.colour.y;
+            _vertexArrays.b[i] = vertex.colour.z;
+        }
+        vertexLighting->lightVertices(_vertexArrays, view.camera.position, _litColours);
+    }
+
+    std::vector<RasterVertex<SHADER::ATTRIBUTES>>& rasterVertices = std::get<std::vector<RasterVertex<SHADER::ATTRIBUTES>>>(_rasterVertices);
+    auto transform = [&](uint32_t vertex, RasterVertex<SHADER::ATTRIBUTES>& rasterVertex)
+    {
+        Vertex pRaster;
+        view.toRaster(*vertices[vertex], pRaster);
+
+        rasterVertex.x = pRaster.x;
+        rasterVertex.y = pRaster.y;
+        rasterVertex.z = pRaster.z;
+
+        if (vertexLighting)
+        {
+            Vertex lit = *vertices[vertex];
+            lit.colour = _litColours[_litSlots[vertex]];
+            shader.vertex(lit, rasterVertex.attributes);
+        } else
+        {
+            shader.vertex(*vertices[vertex], rasterVertex.attributes);
+        }
+    };
+
+    if (!culled)
+    {
+        // Transform every vertex once, rather than once for every triangle using it
+        rasterVertices.resize(vertices.size());
+        for (size_t i{0}; i < vertices.size(); ++i) { transform(i, rasterVertices[i]); }
+
+        draw(rasterVertices, sceneObj.lods[level], target, shader);
+        return;
+    }
+
+    for (const Meshlet* meshlet : _drawnMeshlets)
+    {
+        rasterVertices.resize(meshlet->vertices.size());
+        for (size_t i{0}; i < meshlet->vertices.size(); ++i) { transform(meshlet->vertices[i], rasterVertices[i]); }
+
+        draw(rasterVertices, meshlet->indices, target, shader);
+    }
+}
+
+void Renderer::writePPM(std::ostream& os) const
+{
+    os << "P6\n" << _width << " " << _height << "\n255\n";
+    os.write((char*)frameBuffer.data(), _width * _height * 3);        // Consider writing the data "manually", i.e. not using binary output.
+}
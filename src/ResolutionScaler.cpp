@@ -0,0 +1,104 @@
+#include "ResolutionScaler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Each side is rendered at between MIN_SCALE_STEPS / SCALE_STEPS and all of the output resolution
+const uint32_t SCALE_STEPS = 16;
+const uint32_t MIN_SCALE_STEPS = 4;
+
+// Frames within this fraction of the target keep the resolution, so timing noise does not change it every frame
+const float FRAME_TIME_TOLERANCE = 0.1f;
+
+ResolutionScaler::ResolutionScaler(uint32_t width, uint32_t height) :
+    output(width * height), _steps{SCALE_STEPS}, _width{width}, _height{height} {}
+
+uint32_t ResolutionScaler::getWidth() const { return _width; }
+uint32_t ResolutionScaler::getHeight() const { return _height; }
+
+uint32_t ResolutionScaler::getRenderWidth() const { return std::max(1u, _width * _steps / SCALE_STEPS); }
+uint32_t ResolutionScaler::getRenderHeight() const { return std::max(1u, _height * _steps / SCALE_STEPS); }
+
+float ResolutionScaler::getLastMilliseconds() const { return _lastMilliseconds; }
+
+void ResolutionScaler::render(Renderer& renderer, const Camera& camera, Scene& scene)
+{
+    if (targetMilliseconds <= 0) _steps = SCALE_STEPS;
+    renderer.resize(getRenderWidth(), getRenderHeight());
+
+    auto start = std::chrono::steady_clock::now();
+    renderer.render(camera, scene);
+    _lastMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    upscale(renderer);
+
+    if (targetMilliseconds <= 0) return;
+    if (std::abs(_lastMilliseconds - targetMilliseconds) <= targetMilliseconds * FRAME_TIME_TOLERANCE) return;
+
+    // Render time grows with the number of pixels, the square of a side. Only go half of the way to the side that
+    // would hit the target, so that a single slow or fast frame does not swing the resolution.
+    float ideal = _steps * std::sqrt(targetMilliseconds / std::max(_lastMilliseconds, 0.01f));
+    float next = _steps + (ideal - _steps) / 2;
+    _steps = std::clamp<uint32_t>(std::lround(std::max(next, 0.0f)), MIN_SCALE_STEPS, SCALE_STEPS);
+}
+
+void ResolutionScaler::computeSamples(uint32_t from, uint32_t to, std::vector<Sample>& samples)
+{
+    samples.resize(to);
+    for (uint32_t i{0}; i < to; ++i)
+    {
+        // Pixel centres line up, so the image neither shifts nor shrinks
+        float position = std::max(0.0f, (i + 0.5f) * from / to - 0.5f);
+        uint32_t p0 = std::min<uint32_t>(position, from - 1);
+        samples[i] = {p0, std::min(p0 + 1, from - 1), (uint32_t)std::lround((position - p0) * 256)};
+    }
+}
+
+void ResolutionScaler::upscale(const Renderer& renderer)
+{
+    const uint32_t width = renderer.getWidth();
+    const uint32_t height = renderer.getHeight();
+    const Colour* source = renderer.frameBuffer.data();
+
+    if (width == _width && height == _height)
+    {
+        std::copy(renderer.frameBuffer.begin(), renderer.frameBuffer.end(), output.begin());
+        return;
+    }
+
+    // Where every column and row samples only changes with the resolution
+    if (width != _sampledWidth || height != _sampledHeight)
+    {
+        computeSamples(width, _width, _columns);
+        computeSamples(height, _height, _rows);
+        _sampledWidth = width;
+        _sampledHeight = height;
+    }
+
+    // Fixed point weights out of 256, so each channel is a few integer multiplies
+    for (uint32_t y{0}; y < _height; ++y)
+    {
+        const Sample& row = _rows[y];
+        const Colour* top = source + row.p0 * width;
+        const Colour* bottom = source + row.p1 * width;
+        Colour* out = output.data() + y * _width;
+
+        for (uint32_t x{0}; x < _width; ++x)
+        {
+            const Sample& column = _columns[x];
+            auto filter = [&](unsigned char Colour::* channel)
+            {
+                uint32_t upper = top[column.p0].*channel * (256 - column.weight) + top[column.p1].*channel * column.weight;
+                uint32_t lower = bottom[column.p0].*channel * (256 - column.weight) + bottom[column.p1].*channel * column.weight;
+                return (unsigned char)((upper * (256 - row.weight) + lower * row.weight + (1 << 15)) >> 16);
+            };
+            out[x] = Colour(filter(&Colour::x), filter(&Colour::y), filter(&Colour::z));
+        }
+    }
+}
+
+void ResolutionScaler::writePPM(std::ostream& os) const
+{
+    os << "P6\n" << _width << " " << _height << "\n255\n";
+    os.write((char*)output.data(), _width * _height * 3);
+}
@@ -0,0 +1,31 @@
+#include "Scene.h"
+
+void Scene::add(std::shared_ptr<SceneObject> sceneObj) 
+{ 
+    _objects.push_back(sceneObj); 
+    _bvhOutdated = true;
+}
+
+std::shared_ptr<SceneObject> Scene::find(const std::string& name) const
+{
+    for (const auto& sceneObj : _objects)
+    {
+        if (sceneObj->getName() == name) { return sceneObj; }
+    }
+    return nullptr;
+}
+
+const std::vector<std::shared_ptr<SceneObject>>& Scene::getObjects() const { return _objects; }
+
+// No need to refit if the tree is going to be rebuilt anyway
+void Scene::refit(const SceneObject& sceneObj) { if (!_bvhOutdated) _bvh.refit(sceneObj); }
+
+void Scene::cull(const Frustum& frustum, std::vector<std::shared_ptr<SceneObject>>& visible)
+{
+    if (_bvhOutdated)
+    {
+        _bvh.build(_objects);
+        _bvhOutdated = false;
+    }
+    _bvh.cull(frustum, visible);
+}
@@ -0,0 +1,63 @@
+#include "SceneLoader.h"
+#include <algorithm>
+
+SceneLoader::SceneLoader(std::vector<Job> jobs, unsigned threads) : _jobs{std::move(jobs)}, _loaded(_jobs.size()), _finished(_jobs.size())
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<size_t>(threads, _jobs.size());
+
+    _threads.reserve(threads);
+    for (unsigned i{0}; i < threads; ++i) { _threads.emplace_back(&SceneLoader::work, this); }
+}
+
+SceneLoader::~SceneLoader()
+{
+    for (auto& thread : _threads) { thread.join(); }
+}
+
+// Each thread takes the next job not started yet, so a slow object does not hold back the ones after it
+void SceneLoader::work()
+{
+    while (true)
+    {
+        size_t job;
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            if (_started == _jobs.size()) return;
+            job = _started++;
+        }
+
+        std::shared_ptr<SceneObject> sceneObj = _jobs[job]();
+
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _loaded[job] = std::move(sceneObj);
+            _finished[job] = true;
+        }
+        _done.notify_all();
+    }
+}
+
+std::shared_ptr<SceneObject> SceneLoader::next()
+{
+    std::unique_lock<std::mutex> lock{_mutex};
+
+    // Jobs that made no object are skipped
+    while (_handedOver < _jobs.size())
+    {
+        _done.wait(lock, [this] { return _finished[_handedOver]; });
+        std::shared_ptr<SceneObject> sceneObj = std::move(_loaded[_handedOver++]);
+        if (sceneObj) return sceneObj;
+    }
+    return nullptr;
+}
+
+void SceneLoader::finish(Scene& scene)
+{
+    std::unique_lock<std::mutex> lock{_mutex};
+    for (; _handedOver < _jobs.size(); ++_handedOver)
+    {
+        _done.wait(lock, [this] { return _finished[_handedOver]; });
+        if (_loaded[_handedOver]) scene.add(std::move(_loaded[_handedOver]));
+    }
+}
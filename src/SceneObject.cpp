@@ -1,84 +1,106 @@
 #include "SceneObject.h"
 #include "geometry.h"
-#include <fstream>
-#include <sstream>
+#include "Simplify.h"
+#include "ObjLibrary.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <unordered_map>
 
-const std::string OBJ_FILE = "../data/blocks.obj";
+extern const std::string OBJ_FILE = "../data/blocks.obj";
 
-SceneObject::SceneObject(std::string name) : _name{name}
+// Coarser levels are picked until the average triangle covers at least this many pixels
+const float LOD_MIN_TRIANGLE_AREA = 16;
+
+// A level is only kept if it has at most this fraction of the triangles of the level before
+const float LOD_MIN_REDUCTION = 0.9f;
+
+// Levels never go below this many triangles. A mesh as small as a cube cannot lose half of its triangles without
+// losing much of its shape, and drawing it whole costs next to nothing anyway.
+const size_t LOD_MIN_TRIANGLES = 64;
+
+SceneObject::SceneObject(std::string name) : SceneObject(name, *ObjLibrary::open(OBJ_FILE)->load(name)) {}
+
+SceneObject::SceneObject(std::string name, const ObjData& obj) : _name{name}
 {
-    // Verify the object exists in the file path name
-    try
+    const ObjObject* object = obj.findObject(name);
+    if (!object)
     {
-        _inFile.open(OBJ_FILE);
-        if (!_inFile.is_open())
-        {
-            std::cerr << "Could not open file" << std::endl;
-        }
-    } catch(const std::exception& e)
-    {
-        std::cerr << e.what() << '\n';
+        std::cerr << "Could not find object " << name << std::endl;
+        return;
     }
 
-    std::string line, temp;
-    bool objLocated = false;
-    // Parse the obj file for the object we want to get data from
-    while (std::getline(_inFile, line))
-    {
-        std::istringstream iss{line};
-        iss >> temp;
+    const ObjCorner* corners = obj.corners.data() + object->firstTriangle * 3;
+    const size_t cornerCount = object->triangleCount * 3;
 
-        // Object declaration started
-        if (temp == "o")
-        {
-            if (objLocated)
-            {
-                // Break out of reading the file since we hit another object's data now.
-                _inFile.close();
-                break;
-            }
+    // Faces index the file's positions and normals. A position used with different normals (like the corner of a cube)
+    // becomes one vertex for each. Gather the pairs this object uses, in file order, so the vertices made from the first
+    // position listed under the object come first and so on.
+    auto key = [](const ObjCorner& corner) { return (uint64_t(uint32_t(corner.v)) << 32) | uint32_t(corner.vn); };
+    std::vector<uint64_t> used;
+    used.reserve(cornerCount);
+    for (size_t i{0}; i < cornerCount; ++i) { used.push_back(key(corners[i])); }
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
 
-            iss >> temp;
-            if (temp == name)
-            {
-                // Found our target object to get data on
-                objLocated = true;
-            }
-        } else if (objLocated)
+    std::unordered_map<uint64_t, uint32_t> local;
+    int32_t previous = -1;
+    uint32_t position = 0;
+    for (uint64_t pair : used)
+    {
+        int32_t v = int32_t(pair >> 32), vn = int32_t(uint32_t(pair));
+        if (v < 0 || v >= (int32_t)obj.positions.size() || vn >= (int32_t)obj.normals.size())
         {
-            if (temp == "v") // Found vertex data
-            {
-                float x, y, z;
-                iss >> x >> y >> z;
-                std::shared_ptr vPtr = std::make_shared<Vertex>(x,y,z);
-                vertices.push_back(vPtr);
-            } else if (temp == "f") // Found face data.
-            {
-                // Format for each triangulated face: f v1/vt1/vn1 v2/vt2/vn2 v3/vt3/vn3. 
-                // Thus vertices of a triangle can be found from v1, v2, and v3
+            std::cerr << "Object " << name << " references a missing vertex" << std::endl;
+            vertices.clear();
+            sourceVertices.clear();
+            return;
+        }
 
-                int v1, v2, v3;
+        // The pairs are sorted by position, so the count goes up whenever the position changes
+        if (previous >= 0 && v != previous) position++;
+        previous = v;
+        sourceVertices.push_back(position);
 
-                // take the integer part, and discard the rest of the string to move on.
-                iss >> v1 >> temp >> v2 >> temp >> v3 >> temp;
+        local[pair] = vertices.size();
+        vertices.push_back(std::make_shared<Vertex>(obj.positions[v]));
+        if (vn >= 0) vertices.back()->normal = Vec3f(obj.normals[vn]).normalize();
+    }
 
-                // Subtract one to account for 0-indexing. Then modulus 8 to account for faces from previous cubes stacking.
-                // Modulus 8 is a temporary fix since it assumes all objects in the scene have 8 vertices.
-                v1--; v1 %= 8;
-                v2--; v2 %= 8;
-                v3--; v3 %= 8;
+    lods.emplace_back();
+    lods[0].reserve(cornerCount);
+    triangles.reserve(object->triangleCount);
+    for (size_t i{0}; i < cornerCount; i += 3)
+    {
+        uint32_t v[3] = {local[key(corners[i])], local[key(corners[i + 1])], local[key(corners[i + 2])]};
 
-                std::vector<std::shared_ptr<Vertex>> tri = {vertices[v1], vertices[v2], vertices[v3]};
-                triangles.push_back(tri);
-            }
+        std::vector<std::shared_ptr<Vertex>> tri = {vertices[v[0]], vertices[v[1]], vertices[v[2]]};
+        triangles.push_back(tri);
+        lods[0].insert(lods[0].end(), {v[0], v[1], v[2]});
+
+        // Corners without a normal in the file get the average of the faces around them, weighted by area
+        Vec3f faceNormal = (*vertices[v[1]] - *vertices[v[0]]).crossProduct(*vertices[v[2]] - *vertices[v[0]]);
+        for (int k{0}; k < 3; ++k)
+        {
+            if (corners[i + k].vn < 0) vertices[v[k]]->normal = vertices[v[k]]->normal + faceNormal;
         }
     }
+    for (size_t i{0}; i < cornerCount; ++i)
+    {
+        if (corners[i].vn < 0) vertices[local[key(corners[i])]]->normal.normalize();
+    }
+
+    buildLODs();
+
+    std::vector<Vec3f> positions;
+    positions.reserve(vertices.size());
+    for (const auto& vertex : vertices) { positions.push_back(*vertex); }
+    meshlets = buildMeshlets(positions, lods[0]);
 }
 
 // Scene Object Copy constructor
-SceneObject::SceneObject(const SceneObject& original) : _name{original._name}
+SceneObject::SceneObject(const SceneObject& original) : 
+    lods{original.lods}, meshlets{original.meshlets}, sourceVertices{original.sourceVertices}, _name{original._name}
 {
     // Map original vertices to their new ones in a different location in the heap
     std::unordered_map<Vertex*, std::shared_ptr<Vertex>> vertexMap;
@@ -106,6 +128,102 @@ SceneObject::SceneObject(const SceneObject& original) : _name{original._name}
 
 const std::string SceneObject::getName() const { return _name; }
 
+const std::vector<std::shared_ptr<Vertex>>& SceneObject::getVertices() const { return vertices; }
+
+uint64_t SceneObject::getVersion() const { return _version; }
+
+void SceneObject::markChanged() { _version++; }
+
+void SceneObject::buildLODs(uint32_t maxLevels)
+{
+    if (lods.empty()) return;
+    lods.resize(1);
+
+    // Vertices split by normal leave every flat face an island, where collapsing an edge can only delete the face.
+    // Simplify the welded positions instead (see sourceVertices), so edges collapse across the seams.
+    const bool split = sourceVertices.size() == vertices.size();
+    auto weld = [&](uint32_t vertex) { return split ? sourceVertices[vertex] : vertex; };
+
+    // The vertices made from each position, which are consecutive since the pairs were sorted by position
+    std::vector<uint32_t> firstVertex;
+    std::vector<Vec3f> positions;
+    for (uint32_t i{0}; i < vertices.size(); ++i)
+    {
+        if (weld(i) < positions.size()) continue;
+        firstVertex.push_back(i);
+        positions.push_back(*vertices[i]);
+    }
+    firstVertex.push_back(vertices.size());
+
+    std::vector<uint32_t> welded;
+    welded.reserve(lods[0].size());
+    for (uint32_t vertex : lods[0]) { welded.push_back(weld(vertex)); }
+
+    while (lods.size() < maxLevels)
+    {
+        size_t previousTriangles = welded.size() / 3;
+        if (previousTriangles / 2 < LOD_MIN_TRIANGLES) break;
+
+        std::vector<uint32_t> level = simplifyMesh(positions, welded, previousTriangles / 2);
+        if (level.empty() || level.size() / 3 > previousTriangles * LOD_MIN_REDUCTION) break;
+
+        // Each corner goes back to the vertex of its position whose normal is closest to the face's. Either side
+        // of the face will do, as lighting is two sided.
+        std::vector<uint32_t> indices(level.size());
+        for (size_t t{0}; t < level.size(); t += 3)
+        {
+            Vec3f faceNormal = (positions[level[t + 1]] - positions[level[t]]).crossProduct(positions[level[t + 2]] - positions[level[t]]);
+            for (int k{0}; k < 3; ++k)
+            {
+                uint32_t best = firstVertex[level[t + k]];
+                float bestMatch = -1;
+                for (uint32_t v{firstVertex[level[t + k]]}; v < firstVertex[level[t + k] + 1]; ++v)
+                {
+                    float match = std::abs(vertices[v]->normal.dotProduct(faceNormal));
+                    if (match > bestMatch)
+                    {
+                        best = v;
+                        bestMatch = match;
+                    }
+                }
+                indices[t + k] = best;
+            }
+        }
+
+        welded = std::move(level);
+        lods.push_back(std::move(indices));
+    }
+}
+
+uint32_t SceneObject::selectLOD(float projectedSize) const
+{
+    // Area of the circle covered by the object on screen
+    float area = M_PI / 4 * projectedSize * projectedSize;
+
+    uint32_t level = 0;
+    while (level + 1 < lods.size() && area < LOD_MIN_TRIANGLE_AREA * (lods[level].size() / 3)) { level++; }
+    return level;
+}
+
+BoundingBox SceneObject::getBounds() const
+{
+    BoundingBox bounds;
+    for (const auto& vertex : vertices) { bounds.extend(*vertex); }
+    return bounds;
+}
+
+void SceneObject::translate(const Vec3f& offset)
+{
+    for (const auto& vertex : vertices)
+    {
+        vertex->x += offset.x;
+        vertex->y += offset.y;
+        vertex->z += offset.z;
+    }
+    for (Meshlet& meshlet : meshlets) { meshlet.centre = meshlet.centre + offset; }
+    markChanged();
+}
+
 // Cube with all vertices set to black
 Cube::Cube(std::string name) : SceneObject(name) { setColour(Colour()); }
 
@@ -129,14 +247,23 @@ void Cube::setColour(Colour colour)
     {
         vertex->colour = colour;
     }
+    markChanged();
 }
 
 void Cube::setColour(uint8_t index, Colour colour)
 {
-    vertices[index]->colour = colour;
+    for (size_t i{0}; i < vertices.size(); ++i)
+    {
+        if (sourceVertices[i] == index) vertices[i]->colour = colour;
+    }
+    markChanged();
 }
 
 Colour Cube::getColour(uint8_t index) 
 {
-    return vertices[index]->colour;
+    for (size_t i{0}; i < vertices.size(); ++i)
+    {
+        if (sourceVertices[i] == index) return vertices[i]->colour;
+    }
+    return Colour();
 }
\ No newline at end of file
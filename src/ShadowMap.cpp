@@ -0,0 +1,16 @@
+#include "ShadowMap.h"
+
+ShadowMap::ShadowMap(const Camera& light, uint32_t width, uint32_t height) : 
+    view{light, width, height}, depth(width * height, light.farClippingPlane) {}
+
+bool ShadowMap::inShadow(const Vec3f& pWorld) const
+{
+    Vertex pRaster;
+    view.toRaster(pWorld, pRaster);
+
+    if (!(pRaster.x >= 0 && pRaster.x < view.width && pRaster.y >= 0 && pRaster.y < view.height)) return false;
+
+    // Smaller depths win the depth test, so anything that won it by more than the bias is between the point and the light
+    uint32_t x = (uint32_t)pRaster.x, y = (uint32_t)pRaster.y;
+    return pRaster.z > depth[y * view.width + x] + bias;
+}
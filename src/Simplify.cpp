@@ -0,0 +1,208 @@
+#include "Simplify.h"
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+
+// Symmetric 4x4 matrix Q such that v^T Q v is the sum of squared distances from v to a set of planes.
+// Only the upper triangle is stored.
+struct Quadric
+{
+    double a2 = 0, ab = 0, ac = 0, ad = 0;
+    double b2 = 0, bc = 0, bd = 0;
+    double c2 = 0, cd = 0;
+    double d2 = 0;
+
+    // Plane ax + by + cz + d = 0 with a unit normal
+    void addPlane(double a, double b, double c, double d, double weight)
+    {
+        a2 += weight*a*a; ab += weight*a*b; ac += weight*a*c; ad += weight*a*d;
+        b2 += weight*b*b; bc += weight*b*c; bd += weight*b*d;
+        c2 += weight*c*c; cd += weight*c*d;
+        d2 += weight*d*d;
+    }
+
+    void add(const Quadric& q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+    }
+
+    double error(const Vec3f& v) const
+    {
+        double x = v.x, y = v.y, z = v.z;
+        return a2*x*x + 2*ab*x*y + 2*ac*x*z + 2*ad*x
+             + b2*y*y + 2*bc*y*z + 2*bd*y
+             + c2*z*z + 2*cd*z
+             + d2;
+    }
+};
+
+// Boundary edges get a plane perpendicular to their triangle, weighted heavily so the outline is kept
+const double BOUNDARY_WEIGHT = 100.0;
+
+struct Collapse
+{
+    double error;
+    uint32_t from, to;
+    uint32_t fromVersion, toVersion;    // Versions of the vertices when the collapse was evaluated
+
+    bool operator>(const Collapse& other) const { return error > other.error; }
+};
+
+std::vector<uint32_t> simplifyMesh(
+    const std::vector<Vec3f>& positions,
+    const std::vector<uint32_t>& indices,
+    size_t targetTriangles
+)
+{
+    const size_t vertexCount = positions.size();
+    const size_t triangleCount = indices.size() / 3;
+
+    std::vector<uint32_t> tris(indices.begin(), indices.begin() + triangleCount * 3);
+    std::vector<bool> removed(triangleCount, false);
+    size_t remaining = triangleCount;
+
+    if (remaining <= targetTriangles) return tris;
+
+    // Triangles around every vertex
+    std::vector<std::vector<uint32_t>> adjacency(vertexCount);
+    for (uint32_t t{0}; t < triangleCount; ++t)
+    {
+        for (int k{0}; k < 3; ++k) { adjacency[tris[3*t + k]].push_back(t); }
+    }
+
+    // Each vertex starts with the planes of the triangles around it, weighted by area
+    std::vector<Quadric> quadrics(vertexCount);
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+    auto edgeKey = [](uint32_t a, uint32_t b) { return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a; };
+
+    for (uint32_t t{0}; t < triangleCount; ++t)
+    {
+        const Vec3f& p0 = positions[tris[3*t]];
+        const Vec3f& p1 = positions[tris[3*t + 1]];
+        const Vec3f& p2 = positions[tris[3*t + 2]];
+
+        Vec3f normal = (p1 - p0).crossProduct(p2 - p0);
+        double area = normal.length() / 2;
+        if (area <= 0) continue;
+        normal.normalize();
+
+        for (int k{0}; k < 3; ++k)
+        {
+            quadrics[tris[3*t + k]].addPlane(normal.x, normal.y, normal.z, -normal.dotProduct(p0), area);
+            edgeUses[edgeKey(tris[3*t + k], tris[3*t + (k + 1) % 3])]++;
+        }
+    }
+
+    for (uint32_t t{0}; t < triangleCount; ++t)
+    {
+        const Vec3f& p0 = positions[tris[3*t]];
+        const Vec3f& p1 = positions[tris[3*t + 1]];
+        const Vec3f& p2 = positions[tris[3*t + 2]];
+        Vec3f normal = (p1 - p0).crossProduct(p2 - p0);
+
+        for (int k{0}; k < 3; ++k)
+        {
+            uint32_t a = tris[3*t + k], b = tris[3*t + (k + 1) % 3];
+            if (edgeUses[edgeKey(a, b)] != 1) continue;
+
+            Vec3f edge = positions[b] - positions[a];
+            Vec3f perpendicular = edge.crossProduct(normal).normalize();
+            double weight = BOUNDARY_WEIGHT * edge.length();
+            quadrics[a].addPlane(perpendicular.x, perpendicular.y, perpendicular.z, -perpendicular.dotProduct(positions[a]), weight);
+            quadrics[b].addPlane(perpendicular.x, perpendicular.y, perpendicular.z, -perpendicular.dotProduct(positions[a]), weight);
+        }
+    }
+
+    std::vector<uint32_t> versions(vertexCount, 0);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+    // Queues the cheaper direction of collapsing the edge ab
+    auto pushEdge = [&](uint32_t a, uint32_t b)
+    {
+        Quadric q = quadrics[a];
+        q.add(quadrics[b]);
+        double toB = q.error(positions[b]);
+        double toA = q.error(positions[a]);
+        if (toB <= toA) queue.push({toB, a, b, versions[a], versions[b]});
+        else queue.push({toA, b, a, versions[b], versions[a]});
+    };
+
+    for (const auto& [key, uses] : edgeUses) { pushEdge(key >> 32, key & 0xffffffff); }
+
+    // Moving a vertex must not turn any of its remaining triangles around
+    auto flips = [&](uint32_t from, uint32_t to)
+    {
+        for (uint32_t t : adjacency[from])
+        {
+            if (removed[t]) continue;
+
+            uint32_t* tri = &tris[3*t];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) continue;    // Becomes degenerate and is removed
+
+            Vec3f before = (positions[tri[1]] - positions[tri[0]]).crossProduct(positions[tri[2]] - positions[tri[0]]);
+            Vec3f p[3] = {positions[tri[0]], positions[tri[1]], positions[tri[2]]};
+            for (int k{0}; k < 3; ++k) { if (tri[k] == from) p[k] = positions[to]; }
+            Vec3f after = (p[1] - p[0]).crossProduct(p[2] - p[0]);
+
+            if (before.dotProduct(after) <= 0) return true;
+        }
+        return false;
+    };
+
+    while (remaining > targetTriangles && !queue.empty())
+    {
+        Collapse c = queue.top();
+        queue.pop();
+
+        // Skip collapses evaluated before either vertex changed
+        if (c.fromVersion != versions[c.from] || c.toVersion != versions[c.to]) continue;
+        if (flips(c.from, c.to)) continue;
+
+        for (uint32_t t : adjacency[c.from])
+        {
+            if (removed[t]) continue;
+
+            uint32_t* tri = &tris[3*t];
+            if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+            {
+                removed[t] = true;
+                remaining--;
+            } else
+            {
+                for (int k{0}; k < 3; ++k) { if (tri[k] == c.from) tri[k] = c.to; }
+                adjacency[c.to].push_back(t);
+            }
+        }
+        adjacency[c.from].clear();
+
+        quadrics[c.to].add(quadrics[c.from]);
+        versions[c.from]++;
+        versions[c.to]++;
+
+        // Re-evaluate every edge around the vertex that was kept
+        std::vector<uint32_t>& around = adjacency[c.to];
+        around.erase(std::remove_if(around.begin(), around.end(), [&](uint32_t t) { return removed[t]; }), around.end());
+        std::sort(around.begin(), around.end());
+        around.erase(std::unique(around.begin(), around.end()), around.end());
+
+        for (uint32_t t : around)
+        {
+            for (int k{0}; k < 3; ++k)
+            {
+                uint32_t v = tris[3*t + k];
+                if (v != c.to) pushEdge(c.to, v);
+            }
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(remaining * 3);
+    for (uint32_t t{0}; t < triangleCount; ++t)
+    {
+        if (!removed[t]) result.insert(result.end(), tris.begin() + 3*t, tris.begin() + 3*t + 3);
+    }
+    return result;
+}
@@ -0,0 +1,110 @@
+#include "View.h"
+#include <algorithm>
+#include <cmath>
+
+void computeScreenCoordinates(
+    const Camera& camera,           // Contains all the camera settings
+    float &top, float &bottom, float &left, float &right    // Boundaries for our image plane
+)
+{   
+    /* Explanation: 
+        Top and Right can be computed based off of the geometry of the camera model.
+        Essentially, tanx = (filmAH / focalLength) = (right / nearClippingPlane). 
+        Thus, there are two similar triangles being made, one with the camera's settings which are its film aperture and focal length,
+        and the other with the distance between the rightmost edge of the canvas's width and its centre and the near clipping plane, which is the distance between the eye and the canvas.
+        Thus we can use similar triangles to find the rightmost edge's distance from the centre of the canvas.
+        Repeat for top. Due to symmetry, bottom and left are just negatives of top and right.
+    */ 
+    top = ((camera.filmApertureHeight/2) / camera.focalLength) * camera.nearClippingPlane;
+    right = ((camera.filmApertureWidth/2) / camera.focalLength) * camera.nearClippingPlane;
+    bottom = -top;
+    left = -right;
+}
+
+void convertToRaster(
+    const Vertex& pWorld,                // Point in the world coordinate system
+    const Camera& camera,               // Camera object contains near clipping plane data.
+    const Matrix44f& worldToCamera,     // Transforms a vector from world space to camera space. Passed in so it is only computed once per frame.
+    const float& t,                     // Boundaries of the image plane. Used in NDC calculation.
+    const float& b,                     
+    const float& l,
+    const float& r,
+    const uint32_t& imageWidth,         // Dimensions of final image
+    const uint32_t& imageHeight,
+    Vertex &pRaster                      // Point in raster space, which is the only parameter being affected.
+)
+{
+    Vec3f pCamera;      // point in camera coordinate system
+
+    worldToCamera.multVecMatrix(pWorld, pCamera);
+
+    // Convert to screen space
+    Vec2f pScreen;
+    pScreen.x = (pCamera.x / -pCamera.z) * camera.nearClippingPlane;
+    pScreen.y = (pCamera.y / -pCamera.z) * camera.nearClippingPlane;
+    
+    // Conversion from screen space to NDC, which has a range of [-1,1]
+    Vec2f pNDC;
+    pNDC.x = (2*pScreen.x)/(r-l) - (r+l)/(r-l);
+    pNDC.y = (2*pScreen.y)/(t-b) - (t+b)/(t-b);
+
+    // Conversion to raster space, which has range [0, imageWidth], [0, imageHeight]
+    pRaster.x = (pNDC.x + 1)/2 * imageWidth;
+    pRaster.y = (1 - pNDC.y)/2 * imageHeight;  // Recal that y goes from top to bottom, so inverted
+    
+    pRaster.z = -pCamera.z;     // Opposite direction from camera's perspective
+
+    // Set colour of the raster point as the same as the world coordinate's
+    pRaster.colour = pWorld.colour;
+}
+
+// a, b, and c are the vertices of a triangle. We can find the determinant (or area of triangle) by using vectors ab and ac.
+// E(P) > 0 if P is to the right of the edge made by v1 and v2
+// E(P) = 0 if it is on the edge
+// E(P) < 0 if it is to the left of the edge
+float edgeFunction(const Vec3f& v1, const Vec3f& v2, const Vec3f& pixel)
+{
+    // return ((b.x-a.x) * (c.y-a.y) - (c.x-a.x) * (b.y-a.y))/2;
+    float determinant = (pixel.x - v1.x) * (v2.y - v1.y) - (pixel.y - v1.y) * (v2.x - v1.x);
+    return determinant/2;
+}
+
+View::View(const Camera& camera, uint32_t width, uint32_t height) : 
+    camera{camera}, worldToCamera{camera.getWorldToCamera()}, width{width}, height{height}
+{
+    computeScreenCoordinates(camera, top, bottom, left, right);
+}
+
+void View::toRaster(const Vertex& pWorld, Vertex& pRaster) const
+{
+    convertToRaster(pWorld, camera, worldToCamera, top, bottom, left, right, width, height, pRaster);
+}
+
+Rect View::screenBounds(const BoundingBox& box) const
+{
+    const Rect image{0, 0, int32_t(width) - 1, int32_t(height) - 1};
+    float xmin = std::numeric_limits<float>::max(), ymin = xmin;
+    float xmax = -xmin, ymax = -xmin;
+
+    for (int i{0}; i < 8; ++i)
+    {
+        Vec3f corner(i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z);
+
+        // Same side as the frustum (see Frustum.cpp): in front of the camera the raster depth is at most -nearClippingPlane
+        Vertex pRaster;
+        toRaster(corner, pRaster);
+        if (!(pRaster.z <= -camera.nearClippingPlane)) return image;
+
+        xmin = std::min(xmin, pRaster.x); xmax = std::max(xmax, pRaster.x);
+        ymin = std::min(ymin, pRaster.y); ymax = std::max(ymax, pRaster.y);
+    }
+
+    // One pixel of margin, as rasterization rounds the triangle bounds down
+    Rect bounds;
+    bounds.x0 = (int32_t)std::floor(std::clamp(xmin, -1.0f, (float)width)) - 1;
+    bounds.y0 = (int32_t)std::floor(std::clamp(ymin, -1.0f, (float)height)) - 1;
+    bounds.x1 = (int32_t)std::floor(std::clamp(xmax, -1.0f, (float)width)) + 1;
+    bounds.y1 = (int32_t)std::floor(std::clamp(ymax, -1.0f, (float)height)) + 1;
+
+    return {std::max(bounds.x0, image.x0), std::max(bounds.y0, image.y0), std::min(bounds.x1, image.x1), std::min(bounds.y1, image.y1)};
+}